@@ -0,0 +1,160 @@
+// src/BenchRunner.cpp
+#include "BenchRunner.h"
+#include "FileBatch.h"
+#include "Json.h"
+#include "Process.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <sched.h>
+
+BenchRunner::BenchRunner(int cpu) : cpu(cpu) {
+    if (this->cpu >= 0) {
+        return;
+    }
+    // The last allowed CPU is the one least likely to be busy with interrupts and the shell
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+        for (int candidate = 0; candidate < CPU_SETSIZE; ++candidate) {
+            if (CPU_ISSET(candidate, &allowed)) {
+                this->cpu = candidate;
+            }
+        }
+    }
+}
+
+bool BenchRunner::run(const std::string& executable, const std::string& filter, unsigned repetitions,
+                      std::vector<std::pair<std::string, std::vector<double>>>& samples) {
+    ProcessSpec spec;
+    spec.argv = {executable, "--benchmark_format=json", "--benchmark_repetitions=" + std::to_string(repetitions)};
+    if (!filter.empty()) {
+        spec.argv.push_back("--benchmark_filter=" + filter);
+    }
+    spec.stdoutMode = ProcessOutput::Capture;
+    spec.stderrMode = ProcessOutput::Capture;
+
+    // The child inherits the affinity of the thread that spawns it
+    cpu_set_t previous;
+    bool pinned = false;
+    if (cpu >= 0 && sched_getaffinity(0, sizeof(previous), &previous) == 0) {
+        cpu_set_t single;
+        CPU_ZERO(&single);
+        CPU_SET(cpu, &single);
+        pinned = sched_setaffinity(0, sizeof(single), &single) == 0;
+        if (!pinned) {
+            std::cerr << "Warning: could not pin benchmarks to CPU " << cpu << std::endl;
+        }
+    }
+    ProcessResult result = Process::run(spec);
+    if (pinned) {
+        sched_setaffinity(0, sizeof(previous), &previous);
+    }
+
+    JsonValue document;
+    std::string error;
+    if (result.exitCode != 0 || !JsonValue::parse(result.out, document, &error) || !document["benchmarks"].isArray()) {
+        std::cerr << executable << " failed (exit code " << result.exitCode << ")"
+                  << (error.empty() ? "" : ": " + error) << "\n" << result.err << std::endl;
+        return false;
+    }
+
+    // Google Benchmark prints one "iteration" entry per repetition, followed by its own aggregates
+    for (const auto& entry : document["benchmarks"].items()) {
+        if (entry["run_type"].asString("iteration") != "iteration") {
+            continue;
+        }
+        std::string name = entry["run_name"].asString(entry["name"].asString());
+        if (entry["error_occurred"].asBool()) {
+            std::cerr << "Warning: " << name << ": " << entry["error_message"].asString() << std::endl;
+            continue;
+        }
+        std::string unit = entry["time_unit"].asString("ns");
+        double scale = unit == "s" ? 1e9 : unit == "ms" ? 1e6 : unit == "us" ? 1e3 : 1;
+        auto series = std::find_if(samples.begin(), samples.end(), [&](const auto& named) { return named.first == name; });
+        if (series == samples.end()) {
+            series = samples.insert(samples.end(), {name, {}});
+        }
+        series->second.push_back(entry["real_time"].asNumber() * scale);
+    }
+    return true;
+}
+
+BenchSummary BenchRunner::summarize(std::vector<double> samples) {
+    BenchSummary summary;
+    if (samples.empty()) {
+        return summary;
+    }
+    std::sort(samples.begin(), samples.end());
+    auto quantile = [&](double q) {
+        double position = q * (samples.size() - 1);
+        size_t below = static_cast<size_t>(position);
+        size_t above = std::min(below + 1, samples.size() - 1);
+        return samples[below] + (position - below) * (samples[above] - samples[below]);
+    };
+
+    // Tukey's fences: a repetition hit by preemption or a frequency change lands far outside the middle half
+    double q1 = quantile(0.25), q3 = quantile(0.75);
+    double low = q1 - 1.5 * (q3 - q1), high = q3 + 1.5 * (q3 - q1);
+    size_t total = samples.size();
+    samples.erase(std::remove_if(samples.begin(), samples.end(), [&](double value) {
+                      return value < low || value > high;
+                  }),
+                  samples.end());
+    summary.samples = samples.size();
+    summary.rejected = total - samples.size();
+
+    summary.median = quantile(0.5);
+    for (double value : samples) {
+        summary.mean += value;
+    }
+    summary.mean /= samples.size();
+    for (double value : samples) {
+        summary.stddev += (value - summary.mean) * (value - summary.mean);
+    }
+    summary.stddev = samples.size() > 1 ? std::sqrt(summary.stddev / (samples.size() - 1)) : 0;
+    return summary;
+}
+
+bool BenchRunner::load(const std::string& path, std::map<std::string, BenchSummary>& summaries) {
+    JsonValue document;
+    if (!JsonValue::parseFile(path, document) || !document["benchmarks"].isObject()) {
+        return false;
+    }
+    for (const auto& [name, entry] : document["benchmarks"].members()) {
+        BenchSummary& summary = summaries[name];
+        summary.median = entry["median_ns"].asNumber();
+        summary.mean = entry["mean_ns"].asNumber();
+        summary.stddev = entry["stddev_ns"].asNumber();
+        summary.samples = static_cast<size_t>(entry["samples"].asNumber());
+        summary.rejected = static_cast<size_t>(entry["rejected"].asNumber());
+    }
+    return true;
+}
+
+bool BenchRunner::save(const std::string& path, const std::string& commit,
+                       const std::map<std::string, BenchSummary>& summaries) {
+    std::map<std::string, BenchSummary> merged;
+    load(path, merged);
+    for (const auto& [name, summary] : summaries) {
+        merged[name] = summary;
+    }
+
+    JsonValue benchmarks = JsonValue::object();
+    for (const auto& [name, summary] : merged) {
+        JsonValue entry = JsonValue::object();
+        entry.set("median_ns", summary.median);
+        entry.set("mean_ns", summary.mean);
+        entry.set("stddev_ns", summary.stddev);
+        entry.set("samples", summary.samples);
+        entry.set("rejected", summary.rejected);
+        benchmarks.set(name, entry);
+    }
+    JsonValue document = JsonValue::object();
+    document.set("commit", commit);
+    document.set("benchmarks", benchmarks);
+
+    FileBatch batch;
+    batch.write(path, document.dump(2) + "\n");
+    return batch.commit();
+}
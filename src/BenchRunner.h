@@ -0,0 +1,45 @@
+// src/BenchRunner.h
+#ifndef BENCHRUNNER_H
+#define BENCHRUNNER_H
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Repetitions of one benchmark after outlier rejection, in nanoseconds per iteration
+struct BenchSummary {
+    double median = 0;
+    double mean = 0;
+    double stddev = 0;
+    size_t samples = 0;
+    size_t rejected = 0;
+};
+
+// Runs Google Benchmark executables pinned to one CPU, summarizes their repetitions and
+// keeps the summaries of every commit as JSON.
+class BenchRunner {
+public:
+    // cpu < 0 picks the last CPU this process may run on
+    explicit BenchRunner(int cpu);
+
+    int pinnedCpu() const { return cpu; }
+
+    // Adds the real time of every repetition to samples, per benchmark in the order the
+    // executable reports them; false when it fails or prints no results
+    bool run(const std::string& executable, const std::string& filter, unsigned repetitions,
+             std::vector<std::pair<std::string, std::vector<double>>>& samples);
+
+    // Drops samples outside 1.5 interquartile ranges of the middle half
+    static BenchSummary summarize(std::vector<double> samples);
+
+    static bool load(const std::string& path, std::map<std::string, BenchSummary>& summaries);
+    // Merges into the summaries already stored in path, so filtered runs keep the others
+    static bool save(const std::string& path, const std::string& commit,
+                     const std::map<std::string, BenchSummary>& summaries);
+
+private:
+    int cpu;
+};
+
+#endif // BENCHRUNNER_H
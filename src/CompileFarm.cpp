@@ -0,0 +1,271 @@
+// src/CompileFarm.cpp
+#include "CompileFarm.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+// Frames are a 32-bit length followed by that many bytes, so a compiler's diagnostics of any
+// size fit. A request is the working directory and the arguments, each NUL-terminated; the reply
+// is "<exit code> <seconds> <max RSS KiB>\n" followed by the merged output.
+static bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = send(fd, data, size, MSG_NOSIGNAL);
+        if (written <= 0) {
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+static bool readAll(int fd, char* data, size_t size) {
+    while (size > 0) {
+        ssize_t received = recv(fd, data, size, 0);
+        if (received <= 0) {
+            return false;
+        }
+        data += received;
+        size -= static_cast<size_t>(received);
+    }
+    return true;
+}
+
+static bool sendFrame(int fd, const std::string& payload) {
+    uint32_t size = static_cast<uint32_t>(payload.size());
+    return writeAll(fd, reinterpret_cast<const char*>(&size), sizeof(size)) &&
+           writeAll(fd, payload.data(), payload.size());
+}
+
+static bool receiveFrame(int fd, std::string& payload) {
+    uint32_t size = 0;
+    if (!readAll(fd, reinterpret_cast<char*>(&size), sizeof(size))) {
+        return false;
+    }
+    payload.resize(size);
+    return readAll(fd, &payload[0], size);
+}
+
+CompileFarm::CompileFarm(unsigned workerCount) {
+    std::cout.flush();
+    std::cerr.flush();
+    for (unsigned i = 0; i < std::max(1u, workerCount); ++i) {
+        int pair[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, pair) != 0) {
+            break;
+        }
+        pid_t pid = fork();
+        if (pid == 0) {
+            // Only our own end: a worker must see EOF when the scheduler goes away
+            for (int socket : sockets) {
+                close(socket);
+            }
+            close(pair[0]);
+            serveWorker(pair[1]);
+            _exit(0);
+        }
+        close(pair[1]);
+        if (pid < 0) {
+            close(pair[0]);
+            break;
+        }
+        sockets.push_back(pair[0]);
+        workers.push_back(pid);
+    }
+}
+
+CompileFarm::~CompileFarm() {
+    for (int socket : sockets) {
+        close(socket);
+    }
+    for (pid_t pid : workers) {
+        waitpid(pid, nullptr, 0);
+    }
+}
+
+void CompileFarm::serveWorker(int socket) {
+    std::string request;
+    while (receiveFrame(socket, request)) {
+        ProcessSpec spec;
+        size_t pos = request.find('\0');
+        spec.workingDirectory = request.substr(0, pos);
+        while (pos != std::string::npos && pos + 1 < request.size()) {
+            size_t end = request.find('\0', pos + 1);
+            spec.argv.push_back(request.substr(pos + 1, end - pos - 1));
+            pos = end;
+        }
+        spec.stdoutMode = ProcessOutput::Capture;
+        spec.stderrMode = ProcessOutput::MergeIntoStdout;
+        ProcessResult result = Process::run(spec);
+        std::ostringstream reply;
+        reply << result.exitCode << " " << result.seconds << " " << result.maxRssKb << "\n" << result.out;
+        if (!sendFrame(socket, reply.str())) {
+            break;
+        }
+    }
+    close(socket);
+}
+
+std::vector<double> CompileFarm::criticalPaths(const std::vector<FarmJob>& jobs) {
+    std::vector<std::vector<size_t>> dependents(jobs.size());
+    for (size_t job = 0; job < jobs.size(); ++job) {
+        for (size_t dependency : jobs[job].dependencies) {
+            dependents[dependency].push_back(job);
+        }
+    }
+    std::vector<double> paths(jobs.size(), -1);
+    std::function<double(size_t)> visit = [&](size_t job) {
+        if (paths[job] < 0) {
+            paths[job] = jobs[job].estimate; // also ends a cycle, should there be one
+            double longest = 0;
+            for (size_t dependent : dependents[job]) {
+                longest = std::max(longest, visit(dependent));
+            }
+            paths[job] = jobs[job].estimate + longest;
+        }
+        return paths[job];
+    };
+    for (size_t job = 0; job < jobs.size(); ++job) {
+        visit(job);
+    }
+    return paths;
+}
+
+bool CompileFarm::run(const std::vector<FarmJob>& jobs,
+                      const std::function<void(size_t, const ProcessResult&)>& onExit) {
+    if (jobs.empty()) {
+        return true;
+    }
+    if (sockets.empty()) {
+        std::cerr << "Failed to start the compile farm workers." << std::endl;
+        return false;
+    }
+
+    std::vector<double> priority = criticalPaths(jobs);
+    std::vector<std::vector<size_t>> dependents(jobs.size());
+    std::vector<size_t> pending(jobs.size());
+    std::vector<size_t> ready;
+    for (size_t job = 0; job < jobs.size(); ++job) {
+        pending[job] = jobs[job].dependencies.size();
+        for (size_t dependency : jobs[job].dependencies) {
+            dependents[dependency].push_back(job);
+        }
+        if (pending[job] == 0) {
+            ready.push_back(job);
+        }
+    }
+    auto moreCritical = [&](size_t a, size_t b) { return priority[a] != priority[b] ? priority[a] > priority[b] : a < b; };
+
+    // Dealt out in order of priority, so every queue starts with one of the longest chains
+    std::vector<Queue> queues(sockets.size());
+    std::sort(ready.begin(), ready.end(), moreCritical);
+    for (size_t i = 0; i < ready.size(); ++i) {
+        queues[i % queues.size()].jobs.push_back(ready[i]);
+    }
+    auto push = [&](Queue& queue, size_t job) {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.insert(std::upper_bound(queue.jobs.begin(), queue.jobs.end(), job, moreCritical), job);
+    };
+    // Our own queue first; otherwise the most critical job at the head of another
+    auto take = [&](size_t self) {
+        while (true) {
+            {
+                std::lock_guard<std::mutex> lock(queues[self].mutex);
+                if (!queues[self].jobs.empty()) {
+                    size_t job = queues[self].jobs.front();
+                    queues[self].jobs.pop_front();
+                    return job;
+                }
+            }
+            size_t victim = self, best = 0;
+            for (size_t i = 0; i < queues.size(); ++i) {
+                std::lock_guard<std::mutex> lock(queues[i].mutex);
+                if (!queues[i].jobs.empty() && (victim == self || moreCritical(queues[i].jobs.front(), best))) {
+                    victim = i;
+                    best = queues[i].jobs.front();
+                }
+            }
+            if (victim != self) {
+                std::lock_guard<std::mutex> lock(queues[victim].mutex);
+                if (!queues[victim].jobs.empty()) {
+                    size_t job = queues[victim].jobs.front();
+                    queues[victim].jobs.pop_front();
+                    return job;
+                }
+            }
+        }
+    };
+
+    // available counts queued jobs not yet claimed by a thread, so a claim always finds one. With
+    // none available and none active, nothing can become ready any more.
+    std::mutex stateMutex;
+    std::condition_variable wake;
+    size_t available = ready.size(), active = 0, finished = 0;
+    bool failed = false;
+
+    auto schedule = [&](size_t self) {
+        int socket = sockets[self];
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(stateMutex);
+                wake.wait(lock, [&] { return failed || available > 0 || active == 0; });
+                if (failed || available == 0) {
+                    return;
+                }
+                --available;
+                ++active;
+            }
+            size_t job = take(self);
+
+            std::string request = jobs[job].workingDirectory + '\0';
+            for (const auto& arg : jobs[job].argv) {
+                request += arg + '\0';
+            }
+            ProcessResult result;
+            std::string reply;
+            if (sendFrame(socket, request) && receiveFrame(socket, reply)) {
+                std::istringstream header(reply.substr(0, reply.find('\n')));
+                header >> result.exitCode >> result.seconds >> result.maxRssKb;
+                result.out = reply.substr(std::min(reply.size(), reply.find('\n') + 1));
+            } else {
+                result.exitCode = 127;
+                result.out = "Lost the connection to compile farm worker " + std::to_string(self) + "\n";
+            }
+
+            std::lock_guard<std::mutex> lock(stateMutex);
+            --active;
+            ++finished;
+            if (onExit) {
+                onExit(job, result);
+            }
+            if (result.exitCode != 0) {
+                failed = true;
+            } else {
+                // Jobs made ready here stay with this thread, next to the outputs they consume
+                for (size_t dependent : dependents[job]) {
+                    if (--pending[dependent] == 0) {
+                        push(queues[self], dependent);
+                        ++available;
+                    }
+                }
+            }
+            wake.notify_all();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < sockets.size(); ++i) {
+        threads.emplace_back(schedule, i);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    return !failed && finished == jobs.size();
+}
@@ -0,0 +1,57 @@
+// src/CompileFarm.h
+#ifndef COMPILEFARM_H
+#define COMPILEFARM_H
+
+#include "Process.h"
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+struct FarmJob {
+    std::string name;                 // the output, in reports and as the key of learned durations
+    std::vector<std::string> argv;
+    std::string workingDirectory;
+    std::vector<size_t> dependencies; // jobs that must succeed first
+    bool link = false;
+    double estimate = 1;              // expected seconds
+};
+
+// Runs a graph of compile and link jobs on worker processes. Each worker is fed over its own
+// socket by one scheduler thread; ready jobs wait in per-thread queues, most critical first,
+// and threads whose queue runs dry steal the most critical job of another. A job's priority is
+// the estimated length of the longest chain it starts, so links that end long chains are
+// reached early instead of queueing behind independent compiles.
+class CompileFarm {
+public:
+    // Forks the workers; call before any other thread exists
+    explicit CompileFarm(unsigned workers);
+    ~CompileFarm();
+    CompileFarm(const CompileFarm&) = delete;
+    CompileFarm& operator=(const CompileFarm&) = delete;
+
+    unsigned workerCount() const { return static_cast<unsigned>(sockets.size()); }
+
+    // Stops starting jobs after the first failure. onExit is called in completion order, one
+    // call at a time; false when a job failed or could not be run.
+    bool run(const std::vector<FarmJob>& jobs, const std::function<void(size_t, const ProcessResult&)>& onExit);
+
+    // Estimated seconds from the start of each job to the end of the longest chain it starts
+    static std::vector<double> criticalPaths(const std::vector<FarmJob>& jobs);
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<size_t> jobs; // most critical first
+    };
+
+    std::vector<int> sockets;
+    std::vector<pid_t> workers;
+
+    static void serveWorker(int socket);
+};
+
+#endif // COMPILEFARM_H
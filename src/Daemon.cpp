@@ -0,0 +1,402 @@
+// src/Daemon.cpp
+#include "Daemon.h"
+#include "FileWatcher.h"
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <iostream>
+#include <poll.h>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+extern char** environ;
+
+// Relative, so the path always fits sockaddr_un; commands run from the project directory
+static const char* const kSocketPath = "build/.cpp-manager/daemon.sock";
+static const char* const kLogPath = "build/.cpp-manager/daemon.log";
+static const size_t kMaxRequest = 256 * 1024;
+
+// Environment variables that change what a build does, part of the key of an up-to-date build
+static const char* const kBuildEnvironment[] = {"PATH", "CC", "CXX", "CFLAGS", "CXXFLAGS", "LDFLAGS", "CONAN_HOME",
+                                                "MAKEFLAGS"};
+
+static int64_t nowSeconds() {
+    return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+static int connectSocket() {
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, kSocketPath, sizeof(address.sun_path) - 1);
+    if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        close(fd);
+        fd = -1;
+    }
+    return fd;
+}
+
+// "<argc> <envc>\n" followed by every argument and environment entry, each NUL-terminated
+static std::string encodeRequest(const std::vector<std::string>& args) {
+    std::vector<std::string> environment;
+    for (char** entry = environ; *entry; ++entry) {
+        environment.push_back(*entry);
+    }
+    std::string payload = std::to_string(args.size()) + " " + std::to_string(environment.size()) + "\n";
+    for (const auto& list : {args, environment}) {
+        for (const auto& value : list) {
+            payload += value;
+            payload += '\0';
+        }
+    }
+    return payload;
+}
+
+static bool decodeRequest(const std::string& payload, std::vector<std::string>& args,
+                          std::vector<std::string>& environment) {
+    std::istringstream counts(payload.substr(0, payload.find('\n')));
+    size_t argc = 0, envc = 0;
+    if (!(counts >> argc >> envc) || payload.find('\n') == std::string::npos) {
+        return false;
+    }
+    size_t pos = payload.find('\n') + 1;
+    for (size_t i = 0; i < argc + envc; ++i) {
+        size_t end = payload.find('\0', pos);
+        if (end == std::string::npos) {
+            return false;
+        }
+        (i < argc ? args : environment).push_back(payload.substr(pos, end - pos));
+        pos = end + 1;
+    }
+    return true;
+}
+
+static void reply(int client, int32_t exitCode) {
+    send(client, &exitCode, sizeof(exitCode), MSG_NOSIGNAL);
+}
+
+static void closeAll(const std::vector<int>& fds) {
+    for (int fd : fds) {
+        close(fd);
+    }
+}
+
+bool Daemon::forward(const std::vector<std::string>& args, int& exitCode) {
+    int sock = connectSocket();
+    if (sock < 0) {
+        return false;
+    }
+
+    std::string payload = encodeRequest(args);
+    iovec data{payload.data(), payload.size()};
+    int fds[3] = {STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(fds))] = {};
+    msghdr message{};
+    message.msg_iov = &data;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    cmsghdr* header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(sizeof(fds));
+    std::memcpy(CMSG_DATA(header), fds, sizeof(fds));
+
+    // Our buffered output has to come before the daemon's
+    std::cout.flush();
+    std::cerr.flush();
+    if (sendmsg(sock, &message, MSG_NOSIGNAL) != static_cast<ssize_t>(payload.size())) {
+        close(sock);
+        return false;
+    }
+
+    // Ctrl+C ends us; the daemon sees the socket close and stops the request
+    int32_t code = 0;
+    ssize_t received;
+    do {
+        received = recv(sock, &code, sizeof(code), 0);
+    } while (received < 0 && errno == EINTR);
+    close(sock);
+    if (received != sizeof(code)) {
+        std::cerr << "Lost the connection to the cpp-manager daemon." << std::endl;
+        code = 1;
+    }
+    exitCode = code;
+    return true;
+}
+
+bool Daemon::start(const Handler& handler, const std::function<void()>& warm) {
+    int existing = connectSocket();
+    if (existing >= 0) {
+        close(existing);
+        std::cerr << "A daemon is already running for this project." << std::endl;
+        return false;
+    }
+
+    // Bound before forking, so the socket accepts as soon as we return; a stale one is replaced
+    std::error_code ec;
+    fs::create_directories(fs::path(kSocketPath).parent_path(), ec);
+    unlink(kSocketPath);
+    int listener = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, kSocketPath, sizeof(address.sun_path) - 1);
+    if (listener < 0 || bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listener, 64) != 0) {
+        std::cerr << "Failed to listen on " << kSocketPath << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    std::cout.flush();
+    std::cerr.flush();
+    pid_t pid = fork();
+    if (pid < 0) {
+        std::cerr << "Failed to start the daemon: " << std::strerror(errno) << std::endl;
+        close(listener);
+        return false;
+    }
+    if (pid > 0) {
+        close(listener);
+        std::cout << "Daemon started (pid " << pid << "), listening on " << kSocketPath << ". Log: " << kLogPath
+                  << std::endl;
+        return true;
+    }
+
+    setsid();
+    int devNull = open("/dev/null", O_RDONLY);
+    int log = open(kLogPath, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    dup2(devNull, STDIN_FILENO);
+    dup2(log >= 0 ? log : devNull, STDOUT_FILENO);
+    dup2(log >= 0 ? log : devNull, STDERR_FILENO);
+    closeAll({devNull, log});
+
+    Daemon daemon(listener, handler, warm);
+    int exitCode = daemon.serve();
+    std::cout.flush();
+    std::cerr.flush();
+    _exit(exitCode);
+}
+
+Daemon::Daemon(int listener, const Handler& handler, const std::function<void()>& warm)
+    : listener(listener), handler(handler), warm(warm), startedAt(nowSeconds()) {}
+
+int Daemon::serve() {
+    signal(SIGPIPE, SIG_IGN);
+    FileWatcher watcher(".");
+    if (!watcher.valid()) {
+        std::cerr << "Failed to initialize inotify." << std::endl;
+        unlink(kSocketPath);
+        return 1;
+    }
+    std::cout << "Daemon " << getpid() << " serving " << fs::current_path().string() << std::endl;
+    warm();
+
+    while (!stopping || !running.empty()) {
+        std::vector<pollfd> fds = {{watcher.descriptor(), POLLIN, 0}};
+        if (!stopping) {
+            fds.push_back({listener, POLLIN, 0});
+        }
+        for (const auto& [pid, request] : running) {
+            if (!request.cancelled) {
+                fds.push_back({request.client, 0, 0}); // POLLHUP is always reported
+            }
+        }
+        // Children are reaped on a short tick; a stale model is rebuilt once changes go quiet
+        int timeout = !running.empty() ? 50 : stale ? 200 : -1;
+        int ready = poll(fds.data(), fds.size(), timeout);
+        if (ready < 0 && errno != EINTR) {
+            break;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            if (watcher.readChanges()) {
+                ++generation;
+                stale = true;
+            }
+        } else if (ready == 0 && stale && running.empty()) {
+            warm();
+            stale = false;
+        }
+        for (size_t i = stopping ? 1 : 2; i < fds.size(); ++i) {
+            if (fds[i].revents & (POLLHUP | POLLERR)) {
+                for (auto& [pid, request] : running) {
+                    if (request.client == fds[i].fd) {
+                        kill(-pid, SIGTERM);
+                        request.cancelled = true;
+                    }
+                }
+            }
+        }
+        reap();
+        if (!stopping && (fds[1].revents & POLLIN)) {
+            accept();
+        }
+    }
+    unlink(kSocketPath);
+    std::cout << "Daemon stopped after " << served << " requests" << std::endl;
+    return 0;
+}
+
+void Daemon::accept() {
+    int client = ::accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+    if (client < 0) {
+        return;
+    }
+    std::string payload(kMaxRequest, '\0');
+    iovec data{&payload[0], payload.size()};
+    alignas(cmsghdr) char control[CMSG_SPACE(3 * sizeof(int))] = {};
+    msghdr message{};
+    message.msg_iov = &data;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    ssize_t length = recvmsg(client, &message, MSG_CMSG_CLOEXEC);
+
+    std::vector<int> fds;
+    for (cmsghdr* header = CMSG_FIRSTHDR(&message); header; header = CMSG_NXTHDR(&message, header)) {
+        if (header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_RIGHTS) {
+            size_t count = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            fds.resize(count);
+            std::memcpy(fds.data(), CMSG_DATA(header), count * sizeof(int));
+        }
+    }
+    std::vector<std::string> args, environment;
+    if (length <= 0 || fds.size() != 3 || !decodeRequest(payload.substr(0, length), args, environment) ||
+        args.empty()) {
+        closeAll(fds);
+        reply(client, 2);
+        close(client);
+        return;
+    }
+    ++served;
+
+    if (args[0] == "daemon") {
+        std::ostringstream out;
+        if (args.size() == 2 && args[1] == "stop") {
+            stopping = true;
+            out << "Daemon stopped." << std::endl;
+        } else {
+            out << "Daemon running (pid " << getpid() << ") for " << nowSeconds() - startedAt << "s: " << served
+                << " requests, " << running.size() << " running, " << generation << " changes seen"
+                << (stale ? ", refreshing" : "") << std::endl;
+        }
+        std::string text = out.str();
+        ssize_t written = write(fds[1], text.data(), text.size());
+        (void)written;
+        closeAll(fds);
+        reply(client, 0);
+        close(client);
+        return;
+    }
+
+    std::string buildKey;
+    if (args[0] == "build") {
+        for (const auto& arg : args) {
+            buildKey += arg + '\0';
+        }
+        for (const char* name : kBuildEnvironment) {
+            for (const auto& variable : environment) {
+                if (variable.rfind(std::string(name) + "=", 0) == 0) {
+                    buildKey += variable + '\0';
+                }
+            }
+        }
+        if (answerUpToDate(client, args, buildKey, fds)) {
+            return;
+        }
+    }
+
+    // The child must see the model as of now
+    if (stale && running.empty()) {
+        warm();
+        stale = false;
+    }
+
+    std::cout.flush();
+    std::cerr.flush();
+    pid_t pid = fork();
+    if (pid == 0) {
+        // Own process group, so a client that goes away takes the compilers with it
+        setpgid(0, 0);
+        signal(SIGPIPE, SIG_DFL);
+        for (int target = 0; target < 3; ++target) {
+            dup2(fds[target], target);
+        }
+        closeAll(fds);
+        close(client);
+        close(listener);
+        clearenv();
+        for (const auto& variable : environment) {
+            putenv(strdup(variable.c_str()));
+        }
+        int exitCode = handler(args);
+        std::cout.flush();
+        std::cerr.flush();
+        _exit(exitCode);
+    }
+    closeAll(fds);
+    if (pid < 0) {
+        reply(client, 1);
+        close(client);
+        return;
+    }
+    Request request;
+    request.client = client;
+    request.generation = stale ? 0 : generation;
+    request.buildKey = buildKey;
+    running[pid] = request;
+}
+
+bool Daemon::answerUpToDate(int client, const std::vector<std::string>& args, const std::string& buildKey,
+                            const std::vector<int>& fds) {
+    auto green = greenBuilds.find(buildKey);
+    std::string buildDir = "build";
+    for (size_t i = 1; i + 1 < args.size(); ++i) {
+        if (args[i] == "--build-dir") {
+            buildDir = args[i + 1];
+        }
+    }
+    // Only sources are watched: a build tree that was removed has to be built again
+    std::error_code ec;
+    if (green == greenBuilds.end() || green->second != generation || stale ||
+        !fs::exists(buildDir + "/CMakeCache.txt", ec)) {
+        return false;
+    }
+    std::string text = "Project is up to date (no changes since the last build).\n";
+    ssize_t written = write(fds[1], text.data(), text.size());
+    (void)written;
+    closeAll(fds);
+    reply(client, 0);
+    close(client);
+    return true;
+}
+
+void Daemon::reap() {
+    int status = 0;
+    pid_t pid;
+    while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+        auto it = running.find(pid);
+        if (it == running.end()) {
+            continue;
+        }
+        int exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+        const Request& request = it->second;
+        // Changes that arrived while it built may not be in the result
+        if (!request.buildKey.empty() && exitCode == 0 && request.generation == generation && !stale) {
+            greenBuilds[request.buildKey] = generation;
+        }
+        reply(request.client, exitCode);
+        close(request.client);
+        running.erase(it);
+    }
+}
@@ -0,0 +1,56 @@
+// src/Daemon.h
+#ifndef DAEMON_H
+#define DAEMON_H
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+// Resident server for the project in the current directory, started with `cpp-manager daemon
+// start`. Clients send their arguments and environment over a Unix socket and pass their stdin,
+// stdout and stderr along (SCM_RIGHTS). Every request runs in a forked child, which starts from
+// the daemon's warm state; inotify tells the daemon when that state has to be rebuilt.
+class Daemon {
+public:
+    // Runs one command in a request child and returns its exit code
+    using Handler = std::function<int(const std::vector<std::string>& args)>;
+
+    // Detaches a daemon; warm runs at startup and again after the project changed. False when
+    // a daemon is already running.
+    static bool start(const Handler& handler, const std::function<void()>& warm);
+    // Runs args in the running daemon with our stdin, stdout and stderr. False when there is
+    // none, so the caller runs the command itself.
+    static bool forward(const std::vector<std::string>& args, int& exitCode);
+
+private:
+    struct Request {
+        int client = -1;
+        uint64_t generation = 0; // of the project files when the request started
+        std::string buildKey;    // set for builds, to remember them as up to date
+        bool cancelled = false;  // the client went away and the child was told to stop
+    };
+
+    Daemon(int listener, const Handler& handler, const std::function<void()>& warm);
+
+    int serve();
+    void accept();
+    void reap();
+    // Answers `build` when nothing changed since the same build last succeeded; true when it did
+    bool answerUpToDate(int client, const std::vector<std::string>& args, const std::string& buildKey,
+                        const std::vector<int>& fds);
+
+    int listener;
+    Handler handler;
+    std::function<void()> warm;
+    uint64_t generation = 0;
+    bool stale = false;
+    bool stopping = false;
+    size_t served = 0;
+    int64_t startedAt = 0;
+    std::map<int, Request> running;              // child pid -> request
+    std::map<std::string, uint64_t> greenBuilds; // build key -> generation of its last success
+};
+
+#endif // DAEMON_H
@@ -0,0 +1,122 @@
+// src/FileBatch.cpp
+#include "FileBatch.h"
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+static bool readFile(const std::string& path, std::string& content) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    content.assign((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return true;
+}
+
+static bool writeAll(int fd, const std::string& content) {
+    size_t offset = 0;
+    while (offset < content.size()) {
+        ssize_t count = ::write(fd, content.data() + offset, content.size() - offset);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count < 0) {
+            return false;
+        }
+        offset += static_cast<size_t>(count);
+    }
+    return true;
+}
+
+void FileBatch::write(const std::string& path, const std::string& content) {
+    files[path] = content;
+}
+
+void FileBatch::append(const std::string& path, const std::string& content) {
+    auto it = files.find(path);
+    if (it == files.end()) {
+        it = files.emplace(path, this->content(path)).first;
+    }
+    it->second += content;
+}
+
+std::string FileBatch::content(const std::string& path) const {
+    auto it = files.find(path);
+    if (it != files.end()) {
+        return it->second;
+    }
+    std::string existing;
+    readFile(path, existing);
+    return existing;
+}
+
+bool FileBatch::commit() {
+    std::vector<std::pair<std::string, std::string>> pending; // temporary, target
+    std::set<std::string> directories;
+    bool ok = true;
+
+    // Write and sync every temporary first, so the renames below happen close together
+    for (const auto& [path, content] : files) {
+        std::string existing;
+        if (readFile(path, existing) && existing == content) {
+            ++unchangedCount;
+            continue;
+        }
+
+        fs::path target(path);
+        std::string directory = target.parent_path().empty() ? "." : target.parent_path().string();
+        std::error_code ec;
+        fs::create_directories(directory, ec);
+
+        std::string temporary = directory + "/." + target.filename().string() + ".tmp" + std::to_string(getpid());
+        int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        // A replaced file keeps its permissions (e.g. generated scripts stay executable)
+        struct stat info;
+        if (fd >= 0 && stat(path.c_str(), &info) == 0) {
+            fchmod(fd, info.st_mode & 07777);
+        }
+        if (fd < 0 || !writeAll(fd, content) || fdatasync(fd) != 0) {
+            std::cerr << "Failed to write " << path << ": " << std::strerror(errno) << std::endl;
+            if (fd >= 0) {
+                close(fd);
+                unlink(temporary.c_str());
+            }
+            ok = false;
+            continue;
+        }
+        close(fd);
+        pending.push_back({temporary, path});
+        directories.insert(directory);
+    }
+
+    for (const auto& [temporary, path] : pending) {
+        if (rename(temporary.c_str(), path.c_str()) != 0) {
+            std::cerr << "Failed to replace " << path << ": " << std::strerror(errno) << std::endl;
+            unlink(temporary.c_str());
+            ok = false;
+            continue;
+        }
+        ++writtenCount;
+    }
+
+    // One fsync per directory makes all the renames in it durable
+    for (const auto& directory : directories) {
+        int fd = open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd >= 0) {
+            fsync(fd);
+            close(fd);
+        }
+    }
+
+    files.clear();
+    return ok;
+}
@@ -0,0 +1,33 @@
+// src/FileBatch.h
+#ifndef FILEBATCH_H
+#define FILEBATCH_H
+
+#include <map>
+#include <string>
+
+// Collects generated files in memory and writes them in one go. Every file is written
+// to a temporary next to it and renamed into place, so readers and crashes only ever
+// see the old or the new content. Files whose content is unchanged are left alone,
+// which keeps their mtimes (and the build) stable.
+class FileBatch {
+public:
+    // Stages content for path, replacing anything staged before
+    void write(const std::string& path, const std::string& content);
+    // Appends to the staged content, or to what is on disk when nothing is staged yet
+    void append(const std::string& path, const std::string& content);
+    // Staged content if any, otherwise what is on disk (empty when missing)
+    std::string content(const std::string& path) const;
+
+    // Writes everything staged and empties the batch; false when a file could not be written
+    bool commit();
+
+    size_t written() const { return writtenCount; }
+    size_t unchanged() const { return unchangedCount; }
+
+private:
+    std::map<std::string, std::string> files;
+    size_t writtenCount = 0;
+    size_t unchangedCount = 0;
+};
+
+#endif // FILEBATCH_H
@@ -0,0 +1,84 @@
+// src/FileWatcher.cpp
+#include "FileWatcher.h"
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+static const uint32_t kWatchMask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE;
+static const char* const kSourceDirs[] = {"src", "include", "test", "bench"};
+
+static bool isSourceDir(const std::string& name) {
+    for (const char* dir : kSourceDirs) {
+        if (name == dir) {
+            return true;
+        }
+    }
+    return false;
+}
+
+FileWatcher::FileWatcher(const std::string& projectDir) : root(projectDir) {
+    fd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    if (fd < 0) {
+        return;
+    }
+    for (const char* dir : kSourceDirs) {
+        watchTree(root / dir);
+    }
+    // The root is watched non-recursively; only the CMake and Conan inputs matter there
+    rootWatch = inotify_add_watch(fd, projectDir.c_str(), kWatchMask);
+}
+
+FileWatcher::~FileWatcher() {
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+void FileWatcher::watchTree(const fs::path& root) {
+    std::error_code ec;
+    if (!fs::is_directory(root, ec)) {
+        return;
+    }
+    watches[inotify_add_watch(fd, root.c_str(), kWatchMask)] = root;
+    for (auto it = fs::recursive_directory_iterator(root, ec); !ec && it != fs::recursive_directory_iterator();
+         it.increment(ec)) {
+        if (it->is_directory()) {
+            watches[inotify_add_watch(fd, it->path().c_str(), kWatchMask)] = it->path();
+        }
+    }
+}
+
+bool FileWatcher::readChanges() {
+    alignas(inotify_event) char buffer[64 * 1024];
+    bool changed = false;
+    ssize_t length;
+    while ((length = read(fd, buffer, sizeof(buffer))) > 0) {
+        for (char* ptr = buffer; ptr < buffer + length;) {
+            auto* event = reinterpret_cast<inotify_event*>(ptr);
+            ptr += sizeof(inotify_event) + event->len;
+
+            std::string name = event->len ? event->name : "";
+            bool newDirectory = (event->mask & IN_ISDIR) && (event->mask & (IN_CREATE | IN_MOVED_TO));
+            if (event->wd == rootWatch) {
+                // A source directory created after the watch started, e.g. the first `create bench`
+                if (newDirectory && isSourceDir(name)) {
+                    watchTree(root / name);
+                    changed = true;
+                } else if (name == "CMakeLists.txt" || name == "conanfile.txt" || name == "conan.lock") {
+                    changed = true;
+                }
+                continue;
+            }
+            // Editor swap and backup files
+            if (name.empty() || name[0] == '.' || name.back() == '~' || fs::path(name).extension() == ".swp") {
+                continue;
+            }
+            if (newDirectory && watches.count(event->wd)) {
+                watchTree(watches[event->wd] / name);
+            }
+            changed = true;
+        }
+    }
+    return changed;
+}
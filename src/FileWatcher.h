@@ -0,0 +1,35 @@
+// src/FileWatcher.h
+#ifndef FILEWATCHER_H
+#define FILEWATCHER_H
+
+#include <filesystem>
+#include <map>
+#include <string>
+
+// inotify watch on the inputs of a project build: src/, include/, test/ and bench/ recursively,
+// and CMakeLists.txt, conanfile.txt and conan.lock in the project root
+class FileWatcher {
+public:
+    explicit FileWatcher(const std::string& projectDir);
+    ~FileWatcher();
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    bool valid() const { return fd >= 0; }
+    // Readable when events are pending, for poll()
+    int descriptor() const { return fd; }
+
+    // Reads the pending events without blocking; true when one of them changed a build input.
+    // New directories are watched as they appear.
+    bool readChanges();
+
+private:
+    std::filesystem::path root;
+    int fd = -1;
+    int rootWatch = -1;
+    std::map<int, std::filesystem::path> watches;
+
+    void watchTree(const std::filesystem::path& root);
+};
+
+#endif // FILEWATCHER_H
@@ -0,0 +1,489 @@
+// src/IncludeGraph.cpp
+#include "IncludeGraph.h"
+#include "FileBatch.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <thread>
+#include <unordered_map>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+static const char* const kIndexHeader = "cpp-manager include index 3";
+
+bool IncludeGraph::isIndexed(const std::string& path) {
+    static const std::set<std::string> extensions = {".cpp", ".cc", ".cxx", ".c++", ".h", ".hh", ".hpp",
+                                                     ".hxx", ".h++", ".inl", ".ipp", ".tpp", ".cppm"};
+    return extensions.count(fs::path(path).extension().string()) != 0;
+}
+
+static uint64_t hashBytes(const char* data, size_t size) {
+    // FNV-1a, 64 bit
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+IncludeGraph::IncludeGraph(const std::string& projectDir) : projectDir(projectDir) {}
+
+std::vector<IncludeDirective> IncludeGraph::parse(const char* data, size_t size) {
+    std::vector<IncludeDirective> directives;
+    const char* end = data + size;
+    for (const char* line = data; line < end;) {
+        const char* lineEnd = static_cast<const char*>(memchr(line, '\n', end - line));
+        if (!lineEnd) {
+            lineEnd = end;
+        }
+        const char* p = line;
+        while (p < lineEnd && (*p == ' ' || *p == '\t')) {
+            ++p;
+        }
+        if (p < lineEnd && *p == '#') {
+            ++p;
+            while (p < lineEnd && (*p == ' ' || *p == '\t')) {
+                ++p;
+            }
+            if (lineEnd - p > 7 && std::equal(p, p + 7, "include")) {
+                p += 7;
+                while (p < lineEnd && (*p == ' ' || *p == '\t')) {
+                    ++p;
+                }
+                if (p < lineEnd && (*p == '"' || *p == '<')) {
+                    char close = *p == '"' ? '"' : '>';
+                    const char* name = ++p;
+                    while (p < lineEnd && *p != close) {
+                        ++p;
+                    }
+                    if (p < lineEnd) {
+                        directives.push_back({std::string(name, p), close == '>'});
+                    }
+                }
+            }
+        } else {
+            // C++20: `import "a.h";` and `import <a>;` are header units; `import a.b;` and the implementation
+            // unit `module a.b;` need the interface unit a/b.cppm
+            auto keyword = [&](const char* word) {
+                size_t length = strlen(word);
+                if (static_cast<size_t>(lineEnd - p) <= length || !std::equal(p, p + length, word) ||
+                    std::isalnum(static_cast<unsigned char>(p[length])) || p[length] == '_') {
+                    return false;
+                }
+                p += length;
+                while (p < lineEnd && (*p == ' ' || *p == '\t')) {
+                    ++p;
+                }
+                return true;
+            };
+            bool exported = keyword("export");
+            bool imported = keyword("import");
+            if ((imported || (!exported && keyword("module"))) && p < lineEnd) {
+                if (imported && (*p == '"' || *p == '<')) {
+                    char close = *p == '"' ? '"' : '>';
+                    const char* name = ++p;
+                    while (p < lineEnd && *p != close) {
+                        ++p;
+                    }
+                    if (p < lineEnd) {
+                        directives.push_back({std::string(name, p), close == '>'});
+                    }
+                } else if (std::isalpha(static_cast<unsigned char>(*p)) || *p == '_') {
+                    std::string module;
+                    while (p < lineEnd && (std::isalnum(static_cast<unsigned char>(*p)) || *p == '_' || *p == '.')) {
+                        module += *p == '.' ? '/' : *p;
+                        ++p;
+                    }
+                    directives.push_back({module + ".cppm", false});
+                }
+            }
+        }
+        line = lineEnd + 1;
+    }
+    return directives;
+}
+
+std::string IncludeGraph::resolve(const std::string& from, const IncludeDirective& directive,
+                                  const std::function<bool(const std::string&)>& exists) {
+    // Quoted includes look next to the including file first; both then search include/ and src/.
+    // Plain string joins are enough unless the spelling has dot segments.
+    bool dotted = directive.header.find("./") != std::string::npos;
+    auto candidate = [&](const std::string& dir) {
+        std::string path = dir.empty() ? directive.header : dir + "/" + directive.header;
+        return dotted ? fs::path(path).lexically_normal().string() : path;
+    };
+    if (!directive.angled) {
+        size_t slash = from.rfind('/');
+        std::string path = candidate(slash == std::string::npos ? "" : from.substr(0, slash));
+        if (exists(path)) {
+            return path;
+        }
+    }
+    for (const char* dir : {"include", "src"}) {
+        std::string path = candidate(dir);
+        if (exists(path)) {
+            return path;
+        }
+    }
+    return "";
+}
+
+bool IncludeGraph::isSource(const std::string& path) {
+    std::string extension = fs::path(path).extension().string();
+    return extension == ".cpp" || extension == ".cc" || extension == ".cxx" || extension == ".c++" ||
+           extension == ".cppm";
+}
+
+// Appends every indexed file below dir (relative to the project) with its stat data
+static void walk(const std::string& projectDir, const std::string& dir,
+                 std::vector<std::pair<std::string, struct stat>>& found) {
+    DIR* handle = opendir((projectDir + "/" + dir).c_str());
+    if (!handle) {
+        return;
+    }
+    while (dirent* entry = readdir(handle)) {
+        std::string name = entry->d_name;
+        if (name == "." || name == "..") {
+            continue;
+        }
+        bool directory = entry->d_type == DT_DIR;
+        if (!directory && entry->d_type != DT_REG && entry->d_type != DT_UNKNOWN && entry->d_type != DT_LNK) {
+            continue;
+        }
+        if (!directory && !IncludeGraph::isIndexed(name) && entry->d_type != DT_UNKNOWN) {
+            continue;
+        }
+        struct stat info;
+        if (fstatat(dirfd(handle), entry->d_name, &info, 0) != 0) {
+            continue;
+        }
+        if (S_ISDIR(info.st_mode)) {
+            walk(projectDir, dir + "/" + name, found);
+        } else if (S_ISREG(info.st_mode) && IncludeGraph::isIndexed(name)) {
+            found.push_back({dir + "/" + name, info});
+        }
+    }
+    closedir(handle);
+}
+
+void IncludeGraph::update(const std::string& indexPath) {
+    std::vector<std::pair<std::string, struct stat>> found;
+    for (const char* dir : {"src", "include", "test", "bench"}) {
+        walk(projectDir, dir, found);
+    }
+    std::sort(found.begin(), found.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    paths.clear();
+    ids.clear();
+    entries.assign(found.size(), Entry());
+    edges.assign(found.size(), {});
+    std::string fileList;
+    for (size_t i = 0; i < found.size(); ++i) {
+        paths.push_back(found[i].first);
+        ids[paths[i]] = i;
+        fileList += paths[i] + "\n";
+        const struct stat& info = found[i].second;
+        entries[i].mtimeNs = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+        entries[i].size = static_cast<uint64_t>(info.st_size);
+    }
+    uint64_t fileSet = hashBytes(fileList.data(), fileList.size());
+
+    // Previous index: "<header> <file set hash>", then per file its path, mtime, size and content
+    // hash, the ids of the files it includes (valid while the file set is the same) and its directives
+    struct Indexed {
+        Entry entry;
+        std::vector<size_t> targets;
+    };
+    std::unordered_map<std::string, Indexed> previous;
+    bool sameFileSet = false;
+    std::ifstream index(indexPath, std::ios::binary | std::ios::ate);
+    std::string content(index ? static_cast<size_t>(index.tellg()) : 0, '\0');
+    index.seekg(0);
+    index.read(&content[0], static_cast<std::streamsize>(content.size()));
+    size_t headerEnd = content.find('\n');
+    std::string header = std::string(kIndexHeader) + " ";
+    if (headerEnd != std::string::npos && content.compare(0, header.size(), header) == 0) {
+        sameFileSet = std::strtoull(content.c_str() + header.size(), nullptr, 16) == fileSet;
+        for (size_t line = headerEnd + 1; line < content.size();) {
+            size_t lineEnd = content.find('\n', line);
+            if (lineEnd == std::string::npos) {
+                lineEnd = content.size();
+            }
+            size_t tab = content.find('\t', line);
+            if (tab == std::string::npos || tab > lineEnd) {
+                line = lineEnd + 1;
+                continue;
+            }
+            Indexed indexed;
+            char* cursor = &content[tab + 1];
+            indexed.entry.mtimeNs = std::strtoll(cursor, &cursor, 10);
+            indexed.entry.size = std::strtoull(cursor, &cursor, 10);
+            indexed.entry.hash = std::strtoull(cursor, &cursor, 16);
+            while (*cursor == ' ') {
+                char* next;
+                size_t target = std::strtoull(cursor + 1, &next, 10);
+                if (next == cursor + 1) {
+                    break;
+                }
+                indexed.targets.push_back(target);
+                cursor = next;
+            }
+            size_t field = cursor - content.data();
+            while (field < lineEnd && content[field] == '\t') {
+                size_t end = std::min(content.find('\t', field + 1), lineEnd);
+                if (end - field > 2) {
+                    indexed.entry.directives.push_back({content.substr(field + 2, end - field - 2), content[field + 1] == '<'});
+                }
+                field = end;
+            }
+            previous.emplace(content.substr(line, tab - line), std::move(indexed));
+            line = lineEnd + 1;
+        }
+    }
+
+    // Files whose mtime and size are unchanged keep their directives (and edges) from the index
+    std::vector<size_t> stale;
+    std::vector<bool> resolved(paths.size());
+    for (size_t i = 0; i < paths.size(); ++i) {
+        auto known = previous.find(paths[i]);
+        if (known != previous.end() && known->second.entry.mtimeNs == entries[i].mtimeNs &&
+            known->second.entry.size == entries[i].size) {
+            entries[i].hash = known->second.entry.hash;
+            entries[i].directives = std::move(known->second.entry.directives);
+            if (sameFileSet) {
+                edges[i] = std::move(known->second.targets);
+                resolved[i] = true;
+            }
+        } else {
+            stale.push_back(i);
+        }
+    }
+
+    // Re-read changed files in parallel; a touched file with the same hash keeps its directives
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> parsed{0};
+    auto worker = [&]() {
+        for (size_t n = next++; n < stale.size(); n = next++) {
+            size_t i = stale[n];
+            Entry& entry = entries[i];
+            int fd = open((projectDir + "/" + paths[i]).c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) {
+                continue;
+            }
+            const char* data = nullptr;
+            void* mapped = entry.size ? mmap(nullptr, entry.size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+            close(fd);
+            if (mapped != MAP_FAILED) {
+                data = static_cast<const char*>(mapped);
+            }
+            entry.hash = hashBytes(data, data ? entry.size : 0);
+            auto known = previous.find(paths[i]);
+            if (known != previous.end() && known->second.entry.hash == entry.hash) {
+                entry.directives = known->second.entry.directives;
+            } else {
+                entry.directives = data ? parse(data, entry.size) : std::vector<IncludeDirective>();
+                ++parsed;
+            }
+            if (data) {
+                munmap(mapped, entry.size);
+            }
+        }
+    };
+    unsigned threads = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), stale.size() / 64 + 1);
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : pool) {
+        thread.join();
+    }
+    reparsedCount = parsed;
+
+    auto exists = [&](const std::string& path) { return ids.count(path) != 0; };
+    reverse.assign(paths.size(), {});
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (!resolved[i]) {
+            edges[i].clear();
+            for (const auto& directive : entries[i].directives) {
+                std::string target = resolve(paths[i], directive, exists);
+                if (!target.empty()) {
+                    edges[i].push_back(ids[target]);
+                }
+            }
+        }
+        for (size_t target : edges[i]) {
+            reverse[target].push_back(i);
+        }
+    }
+
+    if (sameFileSet && stale.empty()) {
+        return;
+    }
+    std::ostringstream out;
+    out << kIndexHeader << " " << std::hex << fileSet << std::dec << "\n";
+    for (size_t i = 0; i < paths.size(); ++i) {
+        out << paths[i] << "\t" << entries[i].mtimeNs << " " << entries[i].size << " " << std::hex << entries[i].hash
+            << std::dec;
+        for (size_t target : edges[i]) {
+            out << " " << target;
+        }
+        for (const auto& directive : entries[i].directives) {
+            out << "\t" << (directive.angled ? '<' : '"') << directive.header;
+        }
+        out << "\n";
+    }
+    FileBatch batch;
+    batch.write(indexPath, out.str());
+    batch.commit();
+}
+
+const std::vector<IncludeDirective>& IncludeGraph::directives(const std::string& file) const {
+    static const std::vector<IncludeDirective> none;
+    auto it = ids.find(file);
+    return it == ids.end() ? none : entries[it->second].directives;
+}
+
+std::set<std::string> IncludeGraph::includes(const std::string& file) const {
+    std::set<std::string> result;
+    auto it = ids.find(file);
+    if (it != ids.end()) {
+        for (size_t target : edges[it->second]) {
+            result.insert(paths[target]);
+        }
+    }
+    return result;
+}
+
+std::set<std::string> IncludeGraph::includers(const std::string& file,
+                                              const std::pair<std::string, std::string>& without) const {
+    std::set<std::string> result;
+    auto it = ids.find(file);
+    if (it == ids.end()) {
+        return result;
+    }
+    auto from = ids.find(without.first);
+    auto to = ids.find(without.second);
+    size_t skipFrom = from != ids.end() ? from->second : paths.size();
+    size_t skipTo = to != ids.end() ? to->second : paths.size();
+    std::vector<bool> seen(paths.size());
+    std::vector<size_t> stack = {it->second};
+    seen[it->second] = true;
+    while (!stack.empty()) {
+        size_t id = stack.back();
+        stack.pop_back();
+        for (size_t includer : reverse[id]) {
+            if (!seen[includer] && !(includer == skipFrom && id == skipTo)) {
+                seen[includer] = true;
+                result.insert(paths[includer]);
+                stack.push_back(includer);
+            }
+        }
+    }
+    return result;
+}
+
+std::vector<std::pair<std::string, size_t>> IncludeGraph::fanout() const {
+    // Walk forward from every translation unit once; a generation stamp avoids clearing the visited set
+    std::vector<size_t> count(paths.size()), stamp(paths.size());
+    size_t generation = 0;
+    std::vector<size_t> stack;
+    for (size_t unit = 0; unit < paths.size(); ++unit) {
+        if (!isSource(paths[unit])) {
+            continue;
+        }
+        ++generation;
+        stamp[unit] = generation;
+        stack.assign(1, unit);
+        while (!stack.empty()) {
+            size_t id = stack.back();
+            stack.pop_back();
+            for (size_t target : edges[id]) {
+                if (stamp[target] != generation) {
+                    stamp[target] = generation;
+                    ++count[target];
+                    stack.push_back(target);
+                }
+            }
+        }
+    }
+
+    std::vector<std::pair<std::string, size_t>> result;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (!isSource(paths[i])) {
+            result.push_back({paths[i], count[i]});
+        }
+    }
+    std::sort(result.begin(), result.end(), [](const auto& a, const auto& b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    });
+    return result;
+}
+
+std::vector<std::vector<std::string>> IncludeGraph::cycles() const {
+    // Tarjan's strongly connected components, iterative so deep include chains cannot overflow the stack
+    const size_t unvisited = static_cast<size_t>(-1);
+    std::vector<size_t> index(paths.size(), unvisited), low(paths.size());
+    std::vector<bool> onStack(paths.size());
+    std::vector<size_t> stack;
+    std::vector<std::vector<std::string>> result;
+    size_t counter = 0;
+
+    for (size_t root = 0; root < paths.size(); ++root) {
+        if (index[root] != unvisited) {
+            continue;
+        }
+        std::vector<std::pair<size_t, size_t>> frames = {{root, 0}}; // node, next edge
+        index[root] = low[root] = counter++;
+        stack.push_back(root);
+        onStack[root] = true;
+        while (!frames.empty()) {
+            auto& [node, edge] = frames.back();
+            if (edge < edges[node].size()) {
+                size_t target = edges[node][edge++];
+                if (index[target] == unvisited) {
+                    index[target] = low[target] = counter++;
+                    stack.push_back(target);
+                    onStack[target] = true;
+                    frames.push_back({target, 0});
+                } else if (onStack[target]) {
+                    low[node] = std::min(low[node], index[target]);
+                }
+                continue;
+            }
+            size_t done = node;
+            frames.pop_back();
+            if (!frames.empty()) {
+                low[frames.back().first] = std::min(low[frames.back().first], low[done]);
+            }
+            if (low[done] != index[done]) {
+                continue;
+            }
+            std::vector<std::string> component;
+            size_t member;
+            do {
+                member = stack.back();
+                stack.pop_back();
+                onStack[member] = false;
+                component.push_back(paths[member]);
+            } while (member != done);
+            bool selfInclude = std::find(edges[done].begin(), edges[done].end(), done) != edges[done].end();
+            if (component.size() > 1 || selfInclude) {
+                std::reverse(component.begin(), component.end());
+                result.push_back(component);
+            }
+        }
+    }
+    return result;
+}
@@ -0,0 +1,73 @@
+// src/IncludeGraph.h
+#ifndef INCLUDEGRAPH_H
+#define INCLUDEGRAPH_H
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <unordered_map>
+#include <vector>
+
+// An #include, a C++20 header unit import, or a named module import spelled as the path of
+// its interface unit ("a/b.cppm" for `import a.b;`)
+struct IncludeDirective {
+    std::string header; // as spelled, without the quotes or brackets
+    bool angled = false;
+};
+
+// #include graph of the files under src/, include/, test/ and bench/. The parsed directives
+// are kept in an on-disk index keyed by mtime, size and content hash, so update() only
+// re-reads files that changed since the last run.
+class IncludeGraph {
+public:
+    explicit IncludeGraph(const std::string& projectDir);
+
+    // Walks the tree and re-parses changed files in parallel; saves the index when anything changed
+    void update(const std::string& indexPath);
+
+    static std::vector<IncludeDirective> parse(const char* data, size_t size);
+    // Project-relative file a directive of from refers to, empty for system and third-party headers
+    static std::string resolve(const std::string& from, const IncludeDirective& directive,
+                               const std::function<bool(const std::string&)>& exists);
+    static bool isSource(const std::string& path);
+    // C++ sources and headers, by extension
+    static bool isIndexed(const std::string& path);
+
+    // Project-relative paths, sorted
+    const std::vector<std::string>& files() const { return paths; }
+    bool contains(const std::string& file) const { return ids.count(file) != 0; }
+    const std::vector<IncludeDirective>& directives(const std::string& file) const;
+    // Project files included directly by file
+    std::set<std::string> includes(const std::string& file) const;
+    // Files that include file directly or through other headers, optionally as if the edge
+    // without.first -> without.second were removed
+    std::set<std::string> includers(const std::string& file,
+                                    const std::pair<std::string, std::string>& without = {}) const;
+    // Headers ordered by how many translation units include them, directly or not
+    std::vector<std::pair<std::string, size_t>> fanout() const;
+    // Groups of files that include each other, each in include order
+    std::vector<std::vector<std::string>> cycles() const;
+
+    size_t reparsed() const { return reparsedCount; }
+
+private:
+    struct Entry {
+        int64_t mtimeNs = 0;
+        uint64_t size = 0;
+        uint64_t hash = 0;
+        std::vector<IncludeDirective> directives;
+    };
+
+    std::string projectDir;
+    std::vector<std::string> paths;
+    std::unordered_map<std::string, size_t> ids;
+    std::vector<Entry> entries;
+    std::vector<std::vector<size_t>> edges;   // file id -> included file ids
+    std::vector<std::vector<size_t>> reverse; // file id -> including file ids
+    size_t reparsedCount = 0;
+};
+
+#endif // INCLUDEGRAPH_H
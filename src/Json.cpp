@@ -0,0 +1,399 @@
+// src/Json.cpp
+#include "Json.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+
+namespace {
+
+class Parser {
+public:
+    explicit Parser(const std::string& text) : text(text) {}
+
+    bool parseDocument(JsonValue& out, std::string* error) {
+        bool ok = parseValue(out, 0);
+        skipWhitespace();
+        if (ok && pos != text.size()) {
+            ok = fail("trailing characters");
+        }
+        if (!ok && error) {
+            *error = message + " at offset " + std::to_string(pos);
+        }
+        return ok;
+    }
+
+private:
+    const std::string& text;
+    size_t pos = 0;
+    std::string message;
+
+    bool fail(const std::string& why) {
+        if (message.empty()) {
+            message = why;
+        }
+        return false;
+    }
+
+    void skipWhitespace() {
+        while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\n' || text[pos] == '\r')) {
+            ++pos;
+        }
+    }
+
+    bool consume(const char* literal) {
+        size_t length = std::char_traits<char>::length(literal);
+        if (text.compare(pos, length, literal) != 0) {
+            return false;
+        }
+        pos += length;
+        return true;
+    }
+
+    bool parseValue(JsonValue& out, int depth) {
+        if (depth > 512) {
+            return fail("nesting too deep");
+        }
+        skipWhitespace();
+        if (pos >= text.size()) {
+            return fail("unexpected end of input");
+        }
+
+        char c = text[pos];
+        if (c == '{') {
+            ++pos;
+            out = JsonValue::object();
+            skipWhitespace();
+            if (pos < text.size() && text[pos] == '}') {
+                ++pos;
+                return true;
+            }
+            while (true) {
+                skipWhitespace();
+                std::string key;
+                if (pos >= text.size() || text[pos] != '"' || !parseString(key)) {
+                    return fail("expected object key");
+                }
+                skipWhitespace();
+                if (pos >= text.size() || text[pos++] != ':') {
+                    return fail("expected ':'");
+                }
+                JsonValue member;
+                if (!parseValue(member, depth + 1)) {
+                    return false;
+                }
+                out.set(key, member);
+                skipWhitespace();
+                if (pos < text.size() && text[pos] == ',') {
+                    ++pos;
+                } else if (pos < text.size() && text[pos] == '}') {
+                    ++pos;
+                    return true;
+                } else {
+                    return fail("expected ',' or '}'");
+                }
+            }
+        }
+        if (c == '[') {
+            ++pos;
+            out = JsonValue::array();
+            skipWhitespace();
+            if (pos < text.size() && text[pos] == ']') {
+                ++pos;
+                return true;
+            }
+            while (true) {
+                JsonValue item;
+                if (!parseValue(item, depth + 1)) {
+                    return false;
+                }
+                out.push_back(item);
+                skipWhitespace();
+                if (pos < text.size() && text[pos] == ',') {
+                    ++pos;
+                } else if (pos < text.size() && text[pos] == ']') {
+                    ++pos;
+                    return true;
+                } else {
+                    return fail("expected ',' or ']'");
+                }
+            }
+        }
+        if (c == '"') {
+            std::string value;
+            if (!parseString(value)) {
+                return false;
+            }
+            out = JsonValue(value);
+            return true;
+        }
+        if (consume("true")) {
+            out = JsonValue(true);
+            return true;
+        }
+        if (consume("false")) {
+            out = JsonValue(false);
+            return true;
+        }
+        if (consume("null")) {
+            out = JsonValue();
+            return true;
+        }
+        if (c == '-' || (c >= '0' && c <= '9')) {
+            const char* begin = text.c_str() + pos;
+            char* end = nullptr;
+            double value = std::strtod(begin, &end);
+            if (end == begin) {
+                return fail("malformed number");
+            }
+            pos += static_cast<size_t>(end - begin);
+            out = JsonValue(value);
+            return true;
+        }
+        return fail("unexpected character");
+    }
+
+    static void appendUtf8(std::string& out, unsigned long codepoint) {
+        if (codepoint < 0x80) {
+            out += static_cast<char>(codepoint);
+        } else if (codepoint < 0x800) {
+            out += static_cast<char>(0xC0 | (codepoint >> 6));
+            out += static_cast<char>(0x80 | (codepoint & 0x3F));
+        } else if (codepoint < 0x10000) {
+            out += static_cast<char>(0xE0 | (codepoint >> 12));
+            out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (codepoint & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (codepoint >> 18));
+            out += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (codepoint & 0x3F));
+        }
+    }
+
+    bool parseHex4(unsigned long& value) {
+        if (pos + 4 > text.size()) {
+            return fail("truncated \\u escape");
+        }
+        value = std::strtoul(text.substr(pos, 4).c_str(), nullptr, 16);
+        pos += 4;
+        return true;
+    }
+
+    bool parseString(std::string& out) {
+        ++pos; // opening quote
+        while (pos < text.size()) {
+            char c = text[pos++];
+            if (c == '"') {
+                return true;
+            }
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (pos >= text.size()) {
+                break;
+            }
+            char escape = text[pos++];
+            switch (escape) {
+                case '"': out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/': out += '/'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': {
+                    unsigned long codepoint = 0;
+                    if (!parseHex4(codepoint)) {
+                        return false;
+                    }
+                    // Surrogate pair
+                    if (codepoint >= 0xD800 && codepoint < 0xDC00 && text.compare(pos, 2, "\\u") == 0) {
+                        pos += 2;
+                        unsigned long low = 0;
+                        if (!parseHex4(low)) {
+                            return false;
+                        }
+                        codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    appendUtf8(out, codepoint);
+                    break;
+                }
+                default:
+                    return fail("invalid escape");
+            }
+        }
+        return fail("unterminated string");
+    }
+};
+
+const JsonValue& nullValue() {
+    static const JsonValue value;
+    return value;
+}
+
+} // namespace
+
+JsonValue::JsonValue(bool value) : valueType(Type::Bool), boolValue(value) {}
+
+JsonValue::JsonValue(const std::string& value) : valueType(Type::String), stringValue(value) {}
+
+JsonValue::JsonValue(const char* value) : valueType(Type::String), stringValue(value) {}
+
+JsonValue JsonValue::array() {
+    JsonValue value;
+    value.valueType = Type::Array;
+    return value;
+}
+
+JsonValue JsonValue::object() {
+    JsonValue value;
+    value.valueType = Type::Object;
+    return value;
+}
+
+bool JsonValue::parse(const std::string& text, JsonValue& out, std::string* error) {
+    Parser parser(text);
+    return parser.parseDocument(out, error);
+}
+
+bool JsonValue::parseFile(const std::string& path, JsonValue& out, std::string* error) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        if (error) {
+            *error = "cannot open " + path;
+        }
+        return false;
+    }
+    std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return parse(text, out, error);
+}
+
+bool JsonValue::asBool(bool fallback) const {
+    return valueType == Type::Bool ? boolValue : fallback;
+}
+
+double JsonValue::asNumber(double fallback) const {
+    return valueType == Type::Number ? numberValue : fallback;
+}
+
+std::string JsonValue::asString(const std::string& fallback) const {
+    return valueType == Type::String ? stringValue : fallback;
+}
+
+const JsonValue& JsonValue::operator[](const std::string& key) const {
+    auto it = objectMembers.find(key);
+    return it != objectMembers.end() ? it->second : nullValue();
+}
+
+const JsonValue& JsonValue::operator[](size_t index) const {
+    return index < arrayItems.size() ? arrayItems[index] : nullValue();
+}
+
+bool JsonValue::contains(const std::string& key) const {
+    return objectMembers.count(key) != 0;
+}
+
+size_t JsonValue::size() const {
+    return valueType == Type::Array ? arrayItems.size() : objectMembers.size();
+}
+
+void JsonValue::push_back(const JsonValue& value) {
+    valueType = Type::Array;
+    arrayItems.push_back(value);
+}
+
+JsonValue& JsonValue::set(const std::string& key, const JsonValue& value) {
+    valueType = Type::Object;
+    return objectMembers[key] = value;
+}
+
+std::string JsonValue::dump(int indent) const {
+    std::string out;
+    dumpTo(out, indent, 0);
+    return out;
+}
+
+void JsonValue::dumpTo(std::string& out, int indent, int depth) const {
+    auto newline = [&](int level) {
+        if (indent >= 0) {
+            out += '\n';
+            out.append(static_cast<size_t>(indent * level), ' ');
+        }
+    };
+
+    switch (valueType) {
+        case Type::Null:
+            out += "null";
+            break;
+        case Type::Bool:
+            out += boolValue ? "true" : "false";
+            break;
+        case Type::Number: {
+            char buffer[32];
+            if (std::isfinite(numberValue) && numberValue == std::floor(numberValue) && std::fabs(numberValue) < 1e15) {
+                std::snprintf(buffer, sizeof(buffer), "%.0f", numberValue);
+            } else {
+                std::snprintf(buffer, sizeof(buffer), "%.17g", std::isfinite(numberValue) ? numberValue : 0.0);
+            }
+            out += buffer;
+            break;
+        }
+        case Type::String:
+            out += '"' + jsonEscape(stringValue) + '"';
+            break;
+        case Type::Array:
+            out += '[';
+            for (size_t i = 0; i < arrayItems.size(); ++i) {
+                out += i ? "," : "";
+                newline(depth + 1);
+                arrayItems[i].dumpTo(out, indent, depth + 1);
+            }
+            if (!arrayItems.empty()) {
+                newline(depth);
+            }
+            out += ']';
+            break;
+        case Type::Object: {
+            out += '{';
+            bool first = true;
+            for (const auto& [key, value] : objectMembers) {
+                out += first ? "" : ",";
+                first = false;
+                newline(depth + 1);
+                out += '"' + jsonEscape(key) + (indent >= 0 ? "\": " : "\":");
+                value.dumpTo(out, indent, depth + 1);
+            }
+            if (!objectMembers.empty()) {
+                newline(depth);
+            }
+            out += '}';
+            break;
+        }
+    }
+}
+
+std::string jsonEscape(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+        switch (c) {
+            case '"': escaped += "\\\""; break;
+            case '\\': escaped += "\\\\"; break;
+            case '\n': escaped += "\\n"; break;
+            case '\r': escaped += "\\r"; break;
+            case '\t': escaped += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char buffer[8];
+                    std::snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+                    escaped += buffer;
+                } else {
+                    escaped += c;
+                }
+        }
+    }
+    return escaped;
+}
@@ -0,0 +1,69 @@
+// src/Json.h
+#ifndef JSON_H
+#define JSON_H
+
+#include <map>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Minimal JSON document model for the files cpp-manager reads and writes
+// (Chrome traces, compile_commands.json, benchmark results, project specs).
+class JsonValue {
+public:
+    enum class Type { Null, Bool, Number, String, Array, Object };
+
+    JsonValue() = default;
+    JsonValue(bool value);
+    template <typename T, typename = std::enable_if_t<std::is_arithmetic_v<T> && !std::is_same_v<T, bool>>>
+    JsonValue(T value) : valueType(Type::Number), numberValue(static_cast<double>(value)) {}
+    JsonValue(const std::string& value);
+    JsonValue(const char* value);
+
+    static JsonValue array();
+    static JsonValue object();
+
+    // Returns false and fills error on malformed input
+    static bool parse(const std::string& text, JsonValue& out, std::string* error = nullptr);
+    static bool parseFile(const std::string& path, JsonValue& out, std::string* error = nullptr);
+
+    Type type() const { return valueType; }
+    bool isNull() const { return valueType == Type::Null; }
+    bool isBool() const { return valueType == Type::Bool; }
+    bool isNumber() const { return valueType == Type::Number; }
+    bool isString() const { return valueType == Type::String; }
+    bool isArray() const { return valueType == Type::Array; }
+    bool isObject() const { return valueType == Type::Object; }
+
+    bool asBool(bool fallback = false) const;
+    double asNumber(double fallback = 0) const;
+    std::string asString(const std::string& fallback = "") const;
+
+    // Lookups on missing keys or indices return a null value
+    const JsonValue& operator[](const std::string& key) const;
+    const JsonValue& operator[](size_t index) const;
+    bool contains(const std::string& key) const;
+    size_t size() const;
+
+    const std::vector<JsonValue>& items() const { return arrayItems; }
+    const std::map<std::string, JsonValue>& members() const { return objectMembers; }
+
+    void push_back(const JsonValue& value);
+    JsonValue& set(const std::string& key, const JsonValue& value);
+
+    std::string dump(int indent = -1) const;
+
+private:
+    Type valueType = Type::Null;
+    bool boolValue = false;
+    double numberValue = 0;
+    std::string stringValue;
+    std::vector<JsonValue> arrayItems;
+    std::map<std::string, JsonValue> objectMembers;
+
+    void dumpTo(std::string& out, int indent, int depth) const;
+};
+
+std::string jsonEscape(const std::string& text);
+
+#endif // JSON_H
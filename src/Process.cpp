@@ -0,0 +1,309 @@
+// src/Process.cpp
+#include "Process.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+namespace {
+
+struct Child {
+    size_t index = 0;
+    pid_t pid = -1;
+    int outFd = -1;
+    int errFd = -1;
+    int pidFd = -1; // readable once the child exited; -1 on kernels without pidfd_open
+    int64_t deadlineUs = 0; // 0 for none
+    TraceSpan span;
+};
+
+int openPidFd(pid_t pid) {
+#ifdef SYS_pidfd_open
+    return static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+#else
+    (void)pid;
+    return -1;
+#endif
+}
+
+std::string commandLine(const std::vector<std::string>& argv) {
+    std::string line;
+    for (const auto& arg : argv) {
+        line += (line.empty() ? "" : " ") + arg;
+    }
+    return line;
+}
+
+// Reads whatever is available without blocking; closes fd on end of file
+void drain(int& fd, std::string& into) {
+    char buffer[64 * 1024];
+    while (fd >= 0) {
+        ssize_t count = read(fd, buffer, sizeof(buffer));
+        if (count > 0) {
+            into.append(buffer, static_cast<size_t>(count));
+        } else if (count == 0 || (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK)) {
+            close(fd);
+            fd = -1;
+        } else if (errno != EINTR) {
+            return;
+        }
+    }
+}
+
+void closeFd(int& fd) {
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+}
+
+bool spawn(const ProcessSpec& spec, Child& child, ProcessResult& result) {
+    if (spec.argv.empty()) {
+        result.exitCode = 127;
+        result.err = "empty command";
+        return false;
+    }
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    int outPipe[2] = {-1, -1};
+    int errPipe[2] = {-1, -1};
+    bool ok = true;
+
+    // Pipes are close-on-exec so concurrent children never hold each other's ends open;
+    // the dup2 in the child clears the flag on its copy
+    if (spec.stdoutMode == ProcessOutput::Capture) {
+        ok = ok && pipe2(outPipe, O_CLOEXEC) == 0;
+        ok = ok && posix_spawn_file_actions_adddup2(&actions, outPipe[1], STDOUT_FILENO) == 0;
+    } else if (spec.stdoutMode == ProcessOutput::Discard) {
+        ok = ok && posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0) == 0;
+    }
+    if (spec.stderrMode == ProcessOutput::Capture) {
+        ok = ok && pipe2(errPipe, O_CLOEXEC) == 0;
+        ok = ok && posix_spawn_file_actions_adddup2(&actions, errPipe[1], STDERR_FILENO) == 0;
+    } else if (spec.stderrMode == ProcessOutput::Discard) {
+        ok = ok && posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0) == 0;
+    } else if (spec.stderrMode == ProcessOutput::MergeIntoStdout) {
+        ok = ok && posix_spawn_file_actions_adddup2(&actions, STDOUT_FILENO, STDERR_FILENO) == 0;
+    }
+    if (!spec.workingDirectory.empty()) {
+        ok = ok && posix_spawn_file_actions_addchdir_np(&actions, spec.workingDirectory.c_str()) == 0;
+    }
+
+    std::vector<char*> argv;
+    for (const auto& arg : spec.argv) {
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+
+    std::vector<std::string> environment;
+    std::vector<char*> envp;
+    if (!spec.environment.empty()) {
+        for (char** entry = environ; *entry; ++entry) {
+            std::string variable = *entry;
+            if (!spec.environment.count(variable.substr(0, variable.find('=')))) {
+                environment.push_back(variable);
+            }
+        }
+        for (const auto& [name, value] : spec.environment) {
+            environment.push_back(name + "=" + value);
+        }
+        for (auto& variable : environment) {
+            envp.push_back(const_cast<char*>(variable.c_str()));
+        }
+        envp.push_back(nullptr);
+    }
+
+    // Our buffered output has to come before the child's
+    if (spec.stdoutMode == ProcessOutput::Inherit || spec.stderrMode == ProcessOutput::Inherit) {
+        std::cout.flush();
+        std::cerr.flush();
+    }
+
+    int error = ok ? posix_spawnp(&child.pid, argv[0], &actions, nullptr, argv.data(),
+                                  envp.empty() ? environ : envp.data())
+                   : errno;
+    posix_spawn_file_actions_destroy(&actions);
+    closeFd(outPipe[1]);
+    closeFd(errPipe[1]);
+
+    if (error != 0) {
+        closeFd(outPipe[0]);
+        closeFd(errPipe[0]);
+        result.exitCode = 127;
+        result.err = spec.argv[0] + ": " + std::strerror(error);
+        return false;
+    }
+
+    child.outFd = outPipe[0];
+    child.errFd = errPipe[0];
+    for (int fd : {child.outFd, child.errFd}) {
+        if (fd >= 0) {
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        }
+    }
+    child.pidFd = openPidFd(child.pid);
+    return true;
+}
+
+} // namespace
+
+ProcessResult Process::run(const ProcessSpec& spec) {
+    return runAll({spec}, 1).front();
+}
+
+std::vector<ProcessResult> Process::runAll(const std::vector<ProcessSpec>& specs, unsigned maxParallel,
+                                           const std::function<void(size_t, const ProcessResult&)>& onExit) {
+    std::vector<ProcessResult> results(specs.size());
+    std::vector<Child> running;
+    Trace& trace = Trace::instance();
+    std::string phase = trace.currentPhase();
+    size_t next = 0;
+    maxParallel = std::max(1u, maxParallel);
+
+    auto finish = [&](Child& child, int exitCode, const rusage& usage, const std::string& error) {
+        ProcessResult& result = results[child.index];
+        // Exited: take what is left in the pipes; a grandchild holding them must not block us
+        drain(child.outFd, result.out);
+        drain(child.errFd, result.err);
+        closeFd(child.outFd);
+        closeFd(child.errFd);
+        closeFd(child.pidFd);
+        if (!error.empty()) {
+            result.err += (result.err.empty() || result.err.back() == '\n' ? "" : "\n") + error + "\n";
+        }
+
+        child.span.endUs = trace.nowUs();
+        child.span.exitCode = exitCode;
+        child.span.maxRssKb = usage.ru_maxrss;
+        trace.record(child.span);
+
+        result.exitCode = exitCode;
+        result.maxRssKb = usage.ru_maxrss;
+        result.seconds = (child.span.endUs - child.span.startUs) / 1e6;
+        if (onExit) {
+            onExit(child.index, result);
+        }
+    };
+
+    while (next < specs.size() || !running.empty()) {
+        while (running.size() < maxParallel && next < specs.size()) {
+            Child child;
+            child.index = next++;
+            child.span.name = commandLine(specs[child.index].argv);
+            child.span.phase = phase;
+            child.span.startUs = trace.nowUs();
+            if (specs[child.index].timeoutSeconds > 0) {
+                child.deadlineUs = child.span.startUs + static_cast<int64_t>(specs[child.index].timeoutSeconds * 1e6);
+            }
+            if (spawn(specs[child.index], child, results[child.index])) {
+                running.push_back(child);
+            } else {
+                std::cerr << results[child.index].err << std::endl;
+                if (onExit) {
+                    onExit(child.index, results[child.index]);
+                }
+            }
+        }
+        if (running.empty()) {
+            continue;
+        }
+
+        std::vector<pollfd> fds;
+        int timeoutMs = -1;
+        int64_t now = trace.nowUs();
+        for (const auto& child : running) {
+            for (int fd : {child.outFd, child.errFd, child.pidFd}) {
+                if (fd >= 0) {
+                    fds.push_back({fd, POLLIN, 0});
+                }
+            }
+            // Without a pidfd nothing signals the exit of a child whose pipes are closed
+            if (child.pidFd < 0 && child.outFd < 0 && child.errFd < 0) {
+                timeoutMs = timeoutMs < 0 ? 5 : std::min(timeoutMs, 5);
+            }
+            if (child.deadlineUs > 0) {
+                int untilDeadline = static_cast<int>(std::max<int64_t>(0, (child.deadlineUs - now + 999) / 1000));
+                timeoutMs = timeoutMs < 0 ? untilDeadline : std::min(timeoutMs, untilDeadline);
+            }
+        }
+        if (poll(fds.data(), fds.size(), timeoutMs) < 0 && errno != EINTR) {
+            // Without poll nothing tells us about the children any more; do not leave them behind
+            std::string error = std::string("poll: ") + std::strerror(errno);
+            for (auto& child : running) {
+                kill(child.pid, SIGKILL);
+                int status = 0;
+                rusage usage{};
+                while (wait4(child.pid, &status, 0, &usage) < 0 && errno == EINTR) {
+                }
+                finish(child, -1, usage, error);
+            }
+            running.clear();
+            break;
+        }
+        now = trace.nowUs();
+        for (auto& child : running) {
+            if (child.deadlineUs > 0 && now >= child.deadlineUs && !results[child.index].timedOut) {
+                kill(child.pid, SIGKILL);
+                results[child.index].timedOut = true;
+            }
+        }
+
+        for (auto it = running.begin(); it != running.end();) {
+            Child& child = *it;
+            ProcessResult& result = results[child.index];
+            drain(child.outFd, result.out);
+            drain(child.errFd, result.err);
+
+            int status = 0;
+            rusage usage{};
+            pid_t reaped = wait4(child.pid, &status, WNOHANG, &usage);
+            if (reaped == 0 || (reaped < 0 && errno == EINTR)) {
+                ++it;
+                continue;
+            }
+            if (reaped < 0) {
+                // E.g. ECHILD when SIGCHLD is ignored: the status is lost, which must not read as success
+                finish(child, -1, usage, std::string("wait4: ") + std::strerror(errno));
+            } else {
+                finish(child, WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status), usage, "");
+            }
+            it = running.erase(it);
+        }
+    }
+    return results;
+}
+
+std::string Process::findExecutable(const std::string& program) {
+    if (program.find('/') != std::string::npos) {
+        return access(program.c_str(), X_OK) == 0 ? program : "";
+    }
+    const char* path = getenv("PATH");
+    std::string dirs = path ? path : "/usr/local/bin:/usr/bin:/bin";
+    size_t begin = 0;
+    while (begin <= dirs.size()) {
+        size_t end = dirs.find(':', begin);
+        if (end == std::string::npos) {
+            end = dirs.size();
+        }
+        std::string candidate = (end > begin ? dirs.substr(begin, end - begin) : ".") + "/" + program;
+        struct stat info;
+        if (stat(candidate.c_str(), &info) == 0 && S_ISREG(info.st_mode) && access(candidate.c_str(), X_OK) == 0) {
+            return candidate;
+        }
+        begin = end + 1;
+    }
+    return "";
+}
@@ -0,0 +1,50 @@
+// src/Process.h
+#ifndef PROCESS_H
+#define PROCESS_H
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+// Where a child's stdout/stderr goes
+enum class ProcessOutput {
+    Inherit,         // our own stdout/stderr
+    Capture,         // read into ProcessResult
+    Discard,         // /dev/null
+    MergeIntoStdout  // stderr only: same destination as stdout
+};
+
+struct ProcessSpec {
+    std::vector<std::string> argv;                   // argv[0] is looked up in PATH
+    std::string workingDirectory;                    // ours when empty
+    std::map<std::string, std::string> environment;  // added to, or overriding, ours
+    ProcessOutput stdoutMode = ProcessOutput::Inherit;
+    ProcessOutput stderrMode = ProcessOutput::Inherit;
+    double timeoutSeconds = 0;                       // killed when still running after this long; 0 for no limit
+};
+
+struct ProcessResult {
+    int exitCode = -1; // 128 + signal when killed, 127 when it could not be started, -1 when its status was lost
+    bool timedOut = false;
+    std::string out;
+    std::string err;
+    long maxRssKb = 0;
+    double seconds = 0;
+};
+
+// Runs programs directly with posix_spawn (no shell). Every child is recorded in the Trace.
+class Process {
+public:
+    static ProcessResult run(const ProcessSpec& spec);
+
+    // Runs specs in order with at most maxParallel children alive at once. Captured output is
+    // read with poll() as it arrives; onExit is called in completion order.
+    static std::vector<ProcessResult> runAll(const std::vector<ProcessSpec>& specs, unsigned maxParallel,
+                                             const std::function<void(size_t, const ProcessResult&)>& onExit = nullptr);
+
+    // Full path of program in PATH, empty when it is not installed
+    static std::string findExecutable(const std::string& program);
+};
+
+#endif // PROCESS_H
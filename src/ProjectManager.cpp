@@ -1,5 +1,15 @@
 // src/ProjectManager.cpp
 #include "ProjectManager.h"
+#include "BenchRunner.h"
+#include "CompileFarm.h"
+#include "FileBatch.h"
+#include "FileWatcher.h"
+#include "IncludeGraph.h"
+#include "Json.h"
+#include "Process.h"
+#include "SourceIndex.h"
+#include "TargetGraph.h"
+#include "Trace.h"
 #include <iostream>
 #include <fstream>
 #include <cstdlib>
@@ -7,9 +17,463 @@
 #include <algorithm> // For std::transform
 #include <cctype>    // For std::toupper
 #include <cstdio>    // For popen and pclose
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <tuple>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 namespace fs = std::filesystem;
 
+static const char* const kConfigureManifest = "/cpp-manager.manifest";
+static const char* const kDependencyStamp = "/.cpp-manager/conan-install";
+static const char* const kBenchResults = "/.cpp-manager/bench";
+static const char* const kBuildProfileFile = "/.cpp-manager/profile";
+static const char* const kFarmTimes = "/.cpp-manager/farm-times";
+static const char* const kSourceSnapshot = "/build/.cpp-manager/source-snapshot";
+static const char* const kTrigramIndex = "/build/.cpp-manager/trigram-index";
+static const char* const kBuildProfiles = R"(# Build profiles, selected with `cpp-manager build --profile debug|release|release-lto|pgo|asan`
+option(CPP_MANAGER_LTO "Link-time optimization" OFF)
+set(CPP_MANAGER_MARCH "" CACHE STRING "Target architecture passed to -march, e.g. native or x86-64-v3")
+set(CPP_MANAGER_PGO "" CACHE STRING "Profile-guided optimization phase: generate, use or empty")
+set(CPP_MANAGER_PGO_DIR "${CMAKE_BINARY_DIR}/pgo" CACHE PATH "Profile data of the pgo profile")
+set(CPP_MANAGER_SANITIZE "" CACHE STRING "Sanitizers passed to -fsanitize, e.g. address,undefined")
+if(CPP_MANAGER_LTO)
+    include(CheckIPOSupported)
+    check_ipo_supported(RESULT CPP_MANAGER_LTO_SUPPORTED OUTPUT CPP_MANAGER_LTO_ERROR)
+    if(CPP_MANAGER_LTO_SUPPORTED)
+        set(CMAKE_INTERPROCEDURAL_OPTIMIZATION ON)
+    else()
+        message(WARNING "Link-time optimization is not supported: ${CPP_MANAGER_LTO_ERROR}")
+    endif()
+endif()
+if(CPP_MANAGER_MARCH)
+    add_compile_options(-march=${CPP_MANAGER_MARCH})
+endif()
+if(CPP_MANAGER_SANITIZE)
+    add_compile_options(-fsanitize=${CPP_MANAGER_SANITIZE} -fno-omit-frame-pointer)
+    set(CMAKE_EXE_LINKER_FLAGS "${CMAKE_EXE_LINKER_FLAGS} -fsanitize=${CPP_MANAGER_SANITIZE}")
+    set(CMAKE_SHARED_LINKER_FLAGS "${CMAKE_SHARED_LINKER_FLAGS} -fsanitize=${CPP_MANAGER_SANITIZE}")
+endif()
+if(CPP_MANAGER_PGO STREQUAL "generate")
+    add_compile_options(-fprofile-generate=${CPP_MANAGER_PGO_DIR} -fprofile-update=atomic)
+    set(CMAKE_EXE_LINKER_FLAGS "${CMAKE_EXE_LINKER_FLAGS} -fprofile-generate=${CPP_MANAGER_PGO_DIR}")
+    set(CMAKE_SHARED_LINKER_FLAGS "${CMAKE_SHARED_LINKER_FLAGS} -fprofile-generate=${CPP_MANAGER_PGO_DIR}")
+elseif(CPP_MANAGER_PGO STREQUAL "use" AND CMAKE_CXX_COMPILER_ID MATCHES "Clang")
+    add_compile_options(-fprofile-use=${CPP_MANAGER_PGO_DIR}/default.profdata -Wno-profile-instr-out-of-date)
+elseif(CPP_MANAGER_PGO STREQUAL "use")
+    # Code changed since the training run keeps its profile where it still matches
+    add_compile_options(-fprofile-use=${CPP_MANAGER_PGO_DIR} -Wno-missing-profile -Wno-error=coverage-mismatch)
+    if(NOT CMAKE_CXX_COMPILER_VERSION VERSION_LESS 10)
+        add_compile_options(-fprofile-partial-training)
+    endif()
+endif()
+)";
+static const char* const kBenchmarkPackage = "benchmark/1.8.3";
+static const char* const kConanfileTemplate = R"(
+[requires]
+
+[generators]
+CMakeToolchain
+CMakeDeps
+)";
+static const char* const kDependenciesBegin = "# BEGIN cpp-manager dependencies";
+static const char* const kDependenciesEnd = "# END cpp-manager dependencies";
+
+// The package names in the [requires] section of a conanfile.txt, e.g. "fmt" for fmt/10.2.1
+static std::vector<std::string> conanPackageNames(const std::string& conanfileContent) {
+    std::vector<std::string> names;
+    std::istringstream lines(conanfileContent);
+    std::string line;
+    bool inRequires = false;
+    while (std::getline(lines, line)) {
+        line.erase(0, line.find_first_not_of(" \t"));
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        if (!line.empty() && line[0] == '[') {
+            inRequires = line == "[requires]";
+        } else if (inRequires && !line.empty() && line[0] != '#') {
+            names.push_back(line.substr(0, line.find('/')));
+        }
+    }
+    return names;
+}
+
+// The CMake package and root target CMakeDeps generated in buildDir for each package, in order. Many
+// differ from the reference, e.g. ZLIB and ZLIB::ZLIB for zlib/1.3; the root target of a package with
+// components links all of them. Packages without generated files (not installed yet) are left out.
+static std::vector<std::pair<std::string, std::string>> cmakeDepsPackages(const std::string& buildDir,
+                                                                          const std::vector<std::string>& packages) {
+    std::map<std::string, std::pair<std::string, std::string>> generated;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(buildDir, ec)) {
+        std::string file = entry.path().filename().string();
+        std::string fileName;
+        for (const std::string suffix : {"-config.cmake", "Config.cmake"}) {
+            if (fileName.empty() && file.size() > suffix.size() &&
+                file.compare(file.size() - suffix.size(), suffix.size(), suffix) == 0) {
+                fileName = file.substr(0, file.size() - suffix.size());
+            }
+        }
+        std::ifstream in(buildDir + "/" + fileName + "Targets.cmake");
+        if (fileName.empty() || !in) {
+            continue;
+        }
+        // foreach(_COMPONENT ${<reference name>_COMPONENT_NAMES}) and add_library(<root target> INTERFACE IMPORTED)
+        std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        size_t components = content.find("_COMPONENT_NAMES}");
+        size_t open = content.rfind("${", components);
+        size_t library = content.find("add_library(");
+        while (library != std::string::npos && content.compare(library + 12, 2, "${") == 0) {
+            library = content.find("add_library(", library + 12);
+        }
+        if (components == std::string::npos || open == std::string::npos || library == std::string::npos) {
+            continue;
+        }
+        std::string package = content.substr(open + 2, components - open - 2);
+        size_t end = content.find_first_of(" )", library + 12);
+        generated[package] = {fileName, content.substr(library + 12, end - library - 12)};
+    }
+
+    std::vector<std::pair<std::string, std::string>> result;
+    for (const auto& name : packages) {
+        if (generated.count(name)) {
+            result.push_back(generated[name]);
+        }
+    }
+    return result;
+}
+
+// Conan 2 has no conanbuildinfo.cmake: CMakeDeps writes a config per package for find_package(), and
+// every package is linked to the executable and the module libraries. Google Benchmark is only linked
+// to the bench/ targets. packages are (CMake package, target) pairs from cmakeDepsPackages().
+static std::string dependencyBlock(const std::string& target,
+                                   const std::vector<std::pair<std::string, std::string>>& packages) {
+    std::string block = std::string(kDependenciesBegin) + R"(
+# The packages in conanfile.txt, regenerated by `cpp-manager add` and `build`.
+# Changes between the markers are overwritten.
+)";
+    std::string targets;
+    for (const auto& [name, library] : packages) {
+        if (name != "benchmark") {
+            block += "find_package(" + name + " REQUIRED)\n";
+            targets += " " + library;
+        }
+    }
+    if (!targets.empty()) {
+        block += "foreach(target " + target + " ${CPP_MANAGER_MODULES})\n";
+        block += "    target_link_libraries(${target} PRIVATE" + targets + ")\nendforeach()\n";
+    }
+    return block + kDependenciesEnd + "\n";
+}
+
+// Adds generator to the [generators] section unless it is listed already
+static std::string withGenerator(std::string conanfileContent, const std::string& generator) {
+    if (conanfileContent.find(generator) != std::string::npos) {
+        return conanfileContent;
+    }
+    size_t generators = conanfileContent.find("[generators]");
+    if (generators == std::string::npos) {
+        conanfileContent += "\n[generators]\n" + generator + "\n";
+    } else {
+        size_t lineEnd = conanfileContent.find('\n', generators);
+        conanfileContent.insert(lineEnd == std::string::npos ? conanfileContent.size() : lineEnd + 1,
+                                (lineEnd == std::string::npos ? "\n" : "") + generator + "\n");
+    }
+    return conanfileContent;
+}
+
+static std::string hashContent(const std::string& content) {
+    // FNV-1a, 64 bit
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : content) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    std::ostringstream hex;
+    hex << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return hex.str();
+}
+
+static std::string hashFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return "absent";
+    }
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return hashContent(content);
+}
+
+// Machine-wide state shared by all projects: the Conan installation and its package cache
+static std::string storeDirectory() {
+    const char* home = getenv("HOME");
+    return std::string(home ? home : ".") + "/.cpp-manager";
+}
+
+static uintmax_t directorySize(const std::string& path) {
+    uintmax_t size = 0;
+    std::error_code ec;
+    for (auto it = fs::recursive_directory_iterator(path, ec); !ec && it != fs::recursive_directory_iterator();
+         it.increment(ec)) {
+        if (it->is_regular_file(ec) && !it->is_symlink(ec)) {
+            size += it->file_size(ec);
+        }
+    }
+    return size;
+}
+
+// "1.23 us": nanoseconds in the largest unit that keeps the number at or above one
+static std::string formatNanoseconds(double ns) {
+    const char* units[] = {"ns", "us", "ms", "s"};
+    size_t unit = 0;
+    while (ns >= 1000 && unit < 3) {
+        ns /= 1000;
+        ++unit;
+    }
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(ns < 10 ? 2 : ns < 100 ? 1 : 0) << ns << " " << units[unit];
+    return text.str();
+}
+
+// Also the build_type Conan installs the dependencies for
+static std::string profileBuildType(const std::string& profile) {
+    return profile == "debug" || profile == "asan" ? "Debug" : "Release";
+}
+
+// The tree `test` and `bench` use: --build-dir, else build-<profile> (as `build --configs` lays them out)
+static std::string profileBuildDir(const std::string& profile, const std::string& buildDir) {
+    return !buildDir.empty() ? buildDir : profile.empty() ? "build" : "build-" + profile;
+}
+
+// The CMake cache entries behind a build profile. All of them are set every time, so switching
+// profiles resets what the previous one turned on.
+static bool profileDefinitions(const std::string& profile, const std::string& march, const std::string& pgoPhase,
+                               std::vector<std::string>& definitions) {
+    if (profile != "debug" && profile != "release" && profile != "release-lto" && profile != "pgo" &&
+        profile != "asan") {
+        return false;
+    }
+    bool lto = profile == "release-lto" || profile == "pgo";
+    definitions = {"-DCMAKE_BUILD_TYPE=" + profileBuildType(profile), "-DCPP_MANAGER_LTO=" + std::string(lto ? "ON" : "OFF"),
+                   "-DCPP_MANAGER_MARCH=" + march, "-DCPP_MANAGER_PGO=" + pgoPhase,
+                   "-DCPP_MANAGER_SANITIZE=" + std::string(profile == "asan" ? "address,undefined" : "")};
+    return true;
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+struct TypeLayout {
+    size_t size;
+    size_t align;
+    bool cheap;            // passed by value: scalars, pointers, references and views
+    bool moveOnly = false; // no copy constructor
+};
+
+// Size and alignment on LP64 with libstdc++; false for types we do not know, taken as 8 and 8
+static bool typeLayout(const std::string& type, TypeLayout& layout) {
+    static const std::map<std::string, TypeLayout> known = {
+        {"bool", {1, 1, true}}, {"char", {1, 1, true}}, {"signed char", {1, 1, true}},
+        {"unsigned char", {1, 1, true}}, {"char8_t", {1, 1, true}}, {"int8_t", {1, 1, true}},
+        {"uint8_t", {1, 1, true}}, {"std::byte", {1, 1, true}}, {"short", {2, 2, true}},
+        {"unsigned short", {2, 2, true}}, {"char16_t", {2, 2, true}}, {"int16_t", {2, 2, true}},
+        {"uint16_t", {2, 2, true}}, {"int", {4, 4, true}}, {"unsigned", {4, 4, true}},
+        {"unsigned int", {4, 4, true}}, {"float", {4, 4, true}}, {"char32_t", {4, 4, true}},
+        {"wchar_t", {4, 4, true}}, {"int32_t", {4, 4, true}}, {"uint32_t", {4, 4, true}},
+        {"long", {8, 8, true}}, {"unsigned long", {8, 8, true}}, {"long long", {8, 8, true}},
+        {"unsigned long long", {8, 8, true}}, {"double", {8, 8, true}}, {"size_t", {8, 8, true}},
+        {"ptrdiff_t", {8, 8, true}}, {"intptr_t", {8, 8, true}}, {"uintptr_t", {8, 8, true}},
+        {"int64_t", {8, 8, true}}, {"uint64_t", {8, 8, true}}, {"long double", {16, 16, true}},
+        {"std::string_view", {16, 8, true}}, {"std::span", {16, 8, true}},
+        {"std::string", {32, 8, false}}, {"std::vector", {24, 8, false}}, {"std::unique_ptr", {8, 8, false, true}},
+        {"std::shared_ptr", {16, 8, false}}, {"std::function", {32, 8, false}}, {"std::map", {48, 8, false}},
+        {"std::set", {48, 8, false}}, {"std::unordered_map", {56, 8, false}},
+        {"std::unordered_set", {56, 8, false}}, {"std::thread", {8, 8, false, true}},
+        {"std::jthread", {16, 8, false, true}}, {"std::future", {16, 8, false, true}},
+        {"std::promise", {24, 8, false, true}}, {"std::unique_lock", {16, 8, false, true}},
+        {"std::ifstream", {520, 8, false, true}}, {"std::ofstream", {512, 8, false, true}},
+        {"std::fstream", {528, 8, false, true}},
+    };
+    if (!type.empty() && (type.back() == '*' || type.back() == '&')) {
+        layout = {8, 8, true};
+        return true;
+    }
+    std::string name = type.substr(0, type.find('<'));
+    name.erase(name.find_last_not_of(' ') + 1);
+    auto it = known.find(name);
+    if (it == known.end() && name.compare(0, 5, "std::") == 0) {
+        it = known.find(name.substr(5));
+    }
+    if (it == known.end()) {
+        layout = {8, 8, false};
+        return false;
+    }
+    layout = it->second;
+    return true;
+}
+
+// Offsets of members laid out in order; returns the size, padded to the widest alignment
+static size_t structLayout(const std::vector<std::pair<std::string, std::string>>& members,
+                           std::vector<size_t>& offsets) {
+    size_t offset = 0, align = 1;
+    offsets.clear();
+    for (const auto& member : members) {
+        TypeLayout layout;
+        typeLayout(member.second, layout);
+        offset = (offset + layout.align - 1) / layout.align * layout.align;
+        offsets.push_back(offset);
+        offset += layout.size;
+        align = std::max(align, layout.align);
+    }
+    return (offset + align - 1) / align * align;
+}
+
+static void reportLayout(const std::string& name, const std::vector<std::pair<std::string, std::string>>& entered,
+                         const std::vector<std::pair<std::string, std::string>>& reordered) {
+    std::vector<size_t> offsets;
+    size_t before = structLayout(entered, offsets);
+    size_t after = structLayout(reordered, offsets);
+    size_t payload = 0;
+    std::vector<std::string> assumed;
+    for (const auto& member : reordered) {
+        TypeLayout layout;
+        if (!typeLayout(member.second, layout)) {
+            assumed.push_back(member.second);
+        }
+        payload += layout.size;
+    }
+    std::cout << name << ": " << after << " bytes, " << after - payload << " of them padding (" << before << " and "
+              << before - payload << " in the order entered)" << std::endl;
+    for (size_t i = 0; i < reordered.size(); ++i) {
+        TypeLayout layout;
+        typeLayout(reordered[i].second, layout);
+        std::cout << "  " << std::setw(4) << offsets[i] << "  " << std::setw(3) << layout.size << "  "
+                  << reordered[i].second << " " << reordered[i].first << std::endl;
+    }
+    for (const auto& type : assumed) {
+        std::cout << "  size of " << type << " unknown, taken as 8 bytes aligned to 8" << std::endl;
+    }
+}
+
+// Adds #include lines for the standard names generated code uses, after the file's last #include
+static std::string withStandardIncludes(const std::string& source) {
+    static const std::pair<const char*, const char*> uses[] = {
+        {"std::size_t", "<cstddef>"}, {"std::move(", "<utility>"}, {"std::vector<", "<vector>"}};
+    std::string includes;
+    for (const auto& [name, header] : uses) {
+        if (source.find(name) != std::string::npos && source.find(std::string("#include ") + header) == std::string::npos) {
+            includes += std::string("#include ") + header + "\n";
+        }
+    }
+    if (includes.empty()) {
+        return source;
+    }
+    size_t last = source.rfind("\n#include ");
+    size_t pos = last == std::string::npos ? (source.compare(0, 9, "#include ") == 0 ? source.find('\n') : 0)
+                                           : source.find('\n', last + 1);
+    pos = pos == std::string::npos ? source.size() : (pos == 0 ? 0 : pos + 1);
+    return source.substr(0, pos) + includes + source.substr(pos);
+}
+
+// Words of a command line in compile_commands.json, link.txt or --train, quoted the way a POSIX shell reads them
+static std::vector<std::string> splitCommand(const std::string& command) {
+    std::vector<std::string> words;
+    std::string word;
+    bool inWord = false;
+    char quote = 0;
+    for (size_t i = 0; i < command.size(); ++i) {
+        char c = command[i];
+        if (quote) {
+            if (c == quote) {
+                quote = 0;
+            } else if (c == '\\' && quote == '"' && i + 1 < command.size() &&
+                       std::string("\"\\$`").find(command[i + 1]) != std::string::npos) {
+                word += command[++i];
+            } else {
+                word += c;
+            }
+        } else if (c == '"' || c == '\'') {
+            quote = c;
+            inWord = true;
+        } else if (c == '\\' && i + 1 < command.size()) {
+            word += command[++i];
+            inWord = true;
+        } else if (std::isspace(static_cast<unsigned char>(c))) {
+            if (inWord) {
+                words.push_back(word);
+                word.clear();
+                inWord = false;
+            }
+        } else {
+            word += c;
+            inWord = true;
+        }
+    }
+    if (inWord) {
+        words.push_back(word);
+    }
+    return words;
+}
+
+// Prerequisites in a Makefile-style dependency file written by -MD; false when there is none
+static bool dependencyFileInputs(const std::string& path, std::vector<std::string>& inputs) {
+    std::ifstream in(path);
+    std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    size_t colon = content.find(": ");
+    if (colon == std::string::npos) {
+        return false;
+    }
+    std::string input;
+    for (size_t i = colon + 2; i <= content.size(); ++i) {
+        char c = i < content.size() ? content[i] : '\n';
+        if (c == '\\' && i + 1 < content.size() && content[i + 1] == ' ') {
+            input += content[++i];
+        } else if (c == '\\' && i + 1 < content.size() && content[i + 1] == '\n') {
+            ++i;
+        } else if (std::isspace(static_cast<unsigned char>(c))) {
+            if (!input.empty()) {
+                inputs.push_back(input);
+                input.clear();
+            }
+            if (c == '\n') {
+                break; // the phony targets of -MP follow
+            }
+        } else {
+            input += c;
+        }
+    }
+    return true;
+}
+
+// "net/socket" -> "net.socket", the name of the module whose interface unit is src/net/socket.cppm
+static std::string cxxModuleName(const std::string& path) {
+    std::string name;
+    for (char c : path) {
+        name += c == '/' ? '.' : (std::isalnum(static_cast<unsigned char>(c)) || c == '_') ? c : '_';
+    }
+    return name;
+}
+
+// The line's module declaration, `module a;` or `export module a;`, as "a"; empty for any other line
+static std::string declaredModule(const std::string& line) {
+    std::istringstream words(line);
+    std::string word, name;
+    words >> word;
+    if (word == "export") {
+        words >> word;
+    }
+    if (word != "module" || !(words >> name) || name.empty() || name[0] == ';' || name[0] == ':') {
+        return "";
+    }
+    return name.substr(0, name.find_first_of(";:"));
+}
+
 ProjectManager::ProjectManager(const std::string& projectName)
     : projectName(projectName) {}
 
@@ -19,152 +483,3013 @@ void ProjectManager::initializeProject() {
     createDirectory(projectName + "/include");
     createDirectory(projectName + "/test");
 
-    // Prompt to install the package manager
-    if (promptToInstallPackageManager()) {
-        // Set up Python virtual environment in the root folder
-        setupPythonVirtualEnv();
-        // Create conanfile.txt
-        std::string conanfileContent = R"(
-[requires]
+    // Prompt to install the package manager
+    bool withConan = promptToInstallPackageManager();
+    if (withConan) {
+        // Set up Python virtual environment in the root folder
+        setupPythonVirtualEnv();
+    }
+
+    executeCommand({"git", "init"}, projectName);
+
+    std::map<std::string, std::string> files = projectFiles(withConan ? kConanfileTemplate : "");
+    files["src/main.cpp"] = mainSource();
+    writeFiles(files);
+
+    std::cout << "Project initialized successfully!" << std::endl;
+}
+
+std::map<std::string, std::string> ProjectManager::projectFiles(const std::string& conanfileContent) {
+    std::map<std::string, std::string> files;
+    if (!conanfileContent.empty()) {
+        files["conanfile.txt"] = conanfileContent;
+    }
+
+    // Generate CMakeLists.txt with Conan support
+    files["CMakeLists.txt"] = R"(
+cmake_minimum_required(VERSION 3.12)
+project()" + projectName + R"( VERSION 1.0 LANGUAGES CXX)
+
+set(CMAKE_CXX_STANDARD 17)
+set(CMAKE_CXX_STANDARD_REQUIRED ON)
+
+# Per-TU compile time traces, turned on by `cpp-manager --trace` (Clang only)
+option(CPP_MANAGER_TIME_TRACE "Compile with -ftime-trace" OFF)
+if(CPP_MANAGER_TIME_TRACE AND CMAKE_CXX_COMPILER_ID MATCHES "Clang")
+    add_compile_options(-ftime-trace)
+endif()
+
+# Use a local compiler cache as the compiler launcher when one is installed
+find_program(CCACHE_PROGRAM ccache)
+find_program(SCCACHE_PROGRAM sccache)
+if(CCACHE_PROGRAM)
+    set(CMAKE_CXX_COMPILER_LAUNCHER ${CCACHE_PROGRAM})
+elseif(SCCACHE_PROGRAM)
+    set(CMAKE_CXX_COMPILER_LAUNCHER ${SCCACHE_PROGRAM})
+endif()
+
+)" + kBuildProfiles + R"(
+include_directories(include)
+
+)" + TargetGraph::scan({{"src/main.cpp", mainSource()}}).cmakeBlock(projectName);
+    if (!conanfileContent.empty()) {
+        // Conan dependencies are installed from conan.lock by `cpp-manager build` before CMake runs; the
+        // block is filled in from the generated package files then
+        files["CMakeLists.txt"] += "\n" + dependencyBlock(projectName, {});
+    }
+    return files;
+}
+
+std::string ProjectManager::mainSource() {
+    return R"(
+#include <iostream>
+
+int main() {
+    std::cout << "Hello, World!" << std::endl;
+    return 0;
+}
+)";
+}
+
+bool ProjectManager::initializeFromSpec(const std::string& specPath) {
+    auto start = std::chrono::steady_clock::now();
+    JsonValue spec;
+    std::string error;
+    if (!JsonValue::parseFile(specPath, spec, &error)) {
+        std::cerr << "Failed to read project spec " << specPath << ": " << error << std::endl;
+        return false;
+    }
+    if (projectName.empty()) {
+        projectName = spec["name"].asString();
+    }
+    if (projectName.empty()) {
+        std::cerr << "Project spec " << specPath << " has no \"name\"" << std::endl;
+        return false;
+    }
+
+    std::string codegen = spec["codegen"].asString();
+    if (!codegen.empty() && codegen != "performance") {
+        std::cerr << "Unknown \"codegen\" in " << specPath << ": \"" << codegen << "\"" << std::endl;
+        return false;
+    }
+    performanceCodegen = codegen == "performance";
+
+    auto functionFrom = [](const JsonValue& value) {
+        FunctionSpec function;
+        function.name = value["name"].asString();
+        function.description = value["description"].asString();
+        function.returnType = value["returnType"].asString("void");
+        for (const auto& parameter : value["parameters"].items()) {
+            function.parameters.push_back({parameter["name"].asString(), parameter["type"].asString()});
+        }
+        return function;
+    };
+
+    // Everything is generated in memory first; nothing touches the disk until the spec is known to be valid
+    std::string conanfileContent;
+    if (spec.contains("dependencies")) {
+        conanfileContent = "\n[requires]\n";
+        for (const auto& dependency : spec["dependencies"].items()) {
+            conanfileContent += dependency.asString() + "\n";
+        }
+        conanfileContent += "\n[generators]\nCMakeToolchain\nCMakeDeps\n";
+    }
+    std::map<std::string, std::string> files = projectFiles(conanfileContent);
+    files["src/main.cpp"] = spec["main"].isString() ? spec["main"].asString() : mainSource();
+
+    for (const auto& module : spec["modules"].items()) {
+        std::string name = module["name"].asString();
+        if (name.empty() || name == "main") {
+            std::cerr << "Invalid module name in " << specPath << ": \"" << name << "\"" << std::endl;
+            return false;
+        }
+        bool withHeader = module["header"].asBool();
+        std::string source = moduleSource(name, withHeader);
+        for (const auto& value : module["classes"].items()) {
+            ClassSpec type;
+            type.type = value["type"].asString("class");
+            type.name = value["name"].asString();
+            type.description = value["description"].asString();
+            for (const auto& attribute : value["attributes"].items()) {
+                type.attributes.push_back({attribute["name"].asString(), attribute["type"].asString()});
+            }
+            for (const auto& method : value["methods"].items()) {
+                type.methods.push_back(functionFrom(method));
+            }
+            type.soa = value["soa"].asBool();
+            source += generateClassOrStruct(type) + "\n";
+        }
+        for (const auto& function : module["functions"].items()) {
+            source += generateFunction(functionFrom(function)) + "\n";
+        }
+        files["src/" + name + ".cpp"] = performanceCodegen ? withStandardIncludes(source) : source;
+        if (withHeader) {
+            files["include/" + name + ".h"] = headerSource(name);
+        }
+    }
+
+    TargetGraph::splice(files["CMakeLists.txt"], TargetGraph::scan(files).cmakeBlock(projectName));
+
+    createDirectory(projectName);
+    createDirectory(projectName + "/src");
+    createDirectory(projectName + "/include");
+    createDirectory(projectName + "/test");
+    if (!spec["dependencies"].items().empty() && fs::exists(storeDirectory() + "/venv/bin/conan")) {
+        setupPythonVirtualEnv();
+    }
+    if (spec["git"].asBool(true) && !fs::exists(projectName + "/.git")) {
+        executeCommand({"git", "init", "--quiet"}, projectName);
+    }
+    writeFiles(files);
+
+    std::cout << "Project " << projectName << " generated from " << specPath << ": " << files.size() << " files in "
+              << std::fixed << std::setprecision(1) << secondsSince(start) * 1000 << " ms" << std::endl;
+    return true;
+}
+
+bool ProjectManager::promptToInstallPackageManager() {
+    std::string response;
+    std::cout << "Do you want to install the package manager (Conan)? [y/N]: ";
+    std::getline(std::cin, response);
+
+    // Default to 'N' if the response is empty
+    if (response.empty() || (response[0] != 'y' && response[0] != 'Y')) {
+        std::cout << "Skipping package manager installation." << std::endl;
+        return false;
+    }
+
+    std::cout << "Installing Conan..." << std::endl;
+    return true;
+}
+
+void ProjectManager::setupPythonVirtualEnv() {
+    // Path to the virtual environment in the project root folder
+    std::string venvPath = projectName + "/manager";
+
+    // Check if the virtual environment already exists
+    if (fs::exists(venvPath)) {
+        std::cout << "Virtual environment already exists at " << venvPath << std::endl;
+        return;
+    }
+
+    // One Conan installation serves every project; only the first init pays for pip
+    std::string sharedVenv = storeDirectory() + "/venv";
+    if (!fs::exists(sharedVenv + "/bin/conan")) {
+        createDirectory(storeDirectory());
+        if (executeCommand({"python3", "-m", "venv", sharedVenv}) != 0) {
+            std::cerr << "Failed to create virtual environment at " << sharedVenv << std::endl;
+            return;
+        }
+        if (executeCommand({sharedVenv + "/bin/pip", "install", "conan"}) != 0) {
+            std::cerr << "Failed to install Conan in " << sharedVenv << std::endl;
+            return;
+        }
+        std::cout << "Python virtual environment created and Conan installed in " << sharedVenv << std::endl;
+    }
+
+    std::error_code ec;
+    fs::create_directory_symlink(sharedVenv, venvPath, ec);
+    if (ec) {
+        std::cerr << "Failed to link " << venvPath << " to " << sharedVenv << ": " << ec.message() << std::endl;
+        return;
+    }
+    std::cout << "Using the shared Conan installation in " << sharedVenv << std::endl;
+}
+
+// Adds packages to the [requires] section of a conanfile.txt; a package that is already
+// required gets the new version, the others are appended in order
+static std::string withRequirements(std::string conanfileContent, const std::vector<std::string>& packages) {
+    size_t requiresPos = conanfileContent.find("[requires]");
+    if (requiresPos == std::string::npos) {
+        conanfileContent = "[requires]\n\n" + conanfileContent;
+        requiresPos = 0;
+    }
+    size_t sectionStart = conanfileContent.find('\n', requiresPos) + 1;
+    size_t sectionEnd = std::min(conanfileContent.find("\n[", requiresPos), conanfileContent.size());
+    if (sectionStart > sectionEnd) {
+        sectionStart = sectionEnd;
+    }
+
+    std::vector<std::string> requirements;
+    std::istringstream section(conanfileContent.substr(sectionStart, sectionEnd - sectionStart));
+    std::string line;
+    while (std::getline(section, line)) {
+        if (!line.empty()) {
+            requirements.push_back(line);
+        }
+    }
+
+    for (const auto& package : packages) {
+        std::string name = package.substr(0, package.find('/'));
+        auto existing = std::find_if(requirements.begin(), requirements.end(), [&](const std::string& require) {
+            return require.substr(0, require.find('/')) == name;
+        });
+        if (existing != requirements.end()) {
+            *existing = package;
+        } else {
+            requirements.push_back(package);
+        }
+    }
+
+    std::string requiresContent;
+    for (const auto& require : requirements) {
+        requiresContent += require + "\n";
+    }
+    conanfileContent.replace(sectionStart, sectionEnd - sectionStart, requiresContent);
+    return conanfileContent;
+}
+
+bool ProjectManager::addDependencies(const std::vector<std::string>& packages) {
+    std::string conanfilePath = projectName + "/conanfile.txt";
+    std::ifstream conanfileIn(conanfilePath);
+    std::string conanfileContent = conanfileIn ? std::string((std::istreambuf_iterator<char>(conanfileIn)),
+                                                             std::istreambuf_iterator<char>())
+                                               : kConanfileTemplate;
+    conanfileIn.close();
+    conanfileContent = withGenerator(withRequirements(conanfileContent, packages), "CMakeDeps");
+    dependencies.insert(dependencies.end(), packages.begin(), packages.end());
+
+    // Write the updated conanfile.txt once, then resolve everything in a single Conan run
+    createFile(conanfilePath, conanfileContent);
+
+    std::string buildDir = projectName + "/build";
+    createDirectory(buildDir);
+    if (!installDependencies(buildDir, profileBuildType(buildProfile(buildDir, BuildOptions()).first))) {
+        return false;
+    }
+    wireDependencies(buildDir);
+    for (const auto& package : packages) {
+        std::cout << "Added dependency: " << package << std::endl;
+    }
+    return true;
+}
+
+std::map<std::string, std::string> ProjectManager::dependencyInputs(const std::string& buildDir,
+                                                                    const std::string& buildType) {
+    std::map<std::string, std::string> inputs;
+    inputs["build_type"] = hashContent(buildType);
+    inputs["conanfile.txt"] = hashFile(projectName + "/conanfile.txt");
+    inputs["conan.lock"] = hashFile(projectName + "/conan.lock");
+    inputs["conan_toolchain.cmake"] = hashFile(buildDir + "/conan_toolchain.cmake");
+    inputs["conan"] = hashContent(conanProgram() + "\n" + conanHome());
+
+    // The host profile decides which binaries get installed
+    std::string profilePath = conanProfilePath();
+    inputs["profile"] = hashContent(profilePath + "\n" + hashFile(profilePath));
+    return inputs;
+}
+
+bool ProjectManager::installDependencies(const std::string& buildDir, const std::string& buildType, bool explain) {
+    if (!fs::exists(projectName + "/conanfile.txt")) {
+        return true;
+    }
+
+    std::map<std::string, std::string> recorded;
+    std::ifstream stamp(buildDir + kDependencyStamp);
+    std::string line;
+    while (std::getline(stamp, line)) {
+        size_t space = line.rfind(' ');
+        if (space != std::string::npos) {
+            recorded[line.substr(0, space)] = line.substr(space + 1);
+        }
+    }
+    stamp.close();
+
+    // A new shared home starts without profiles
+    if (!fs::exists(conanProfilePath()) && runConan({"profile", "detect", "--exist-ok"}) != 0) {
+        std::cerr << "Conan failed to detect a default profile" << std::endl;
+        return false;
+    }
+
+    std::string lockfile = fs::absolute(projectName + "/conan.lock").lexically_normal().string();
+    auto inputs = dependencyInputs(buildDir, buildType);
+
+    // Pin revisions whenever the requirements change; packages already in the lockfile keep their pins.
+    // A fresh build tree has no record, so fall back to comparing modification times.
+    std::error_code ec;
+    bool requirementsChanged = recorded.count("conanfile.txt")
+                                   ? recorded["conanfile.txt"] != inputs["conanfile.txt"]
+                                   : fs::last_write_time(projectName + "/conanfile.txt", ec) >
+                                         fs::last_write_time(lockfile, ec);
+    if (inputs["conan.lock"] == "absent" || requirementsChanged) {
+        Trace::Phase phase("conan lock");
+        std::vector<std::string> lockCommand = {"lock", "create", ".", "--lockfile-out=" + lockfile};
+        if (inputs["conan.lock"] != "absent") {
+            lockCommand.push_back("--lockfile=" + lockfile);
+            lockCommand.push_back("--lockfile-partial");
+        }
+        if (runConan(lockCommand) != 0) {
+            std::cerr << "Conan failed to resolve the dependencies in conanfile.txt" << std::endl;
+            return false;
+        }
+        inputs = dependencyInputs(buildDir, buildType);
+    }
+
+    if (inputs == recorded) {
+        std::cout << "  conan install: skipped (conan.lock and profile unchanged)" << std::endl;
+        return true;
+    }
+    if (explain) {
+        for (const auto& [name, hash] : inputs) {
+            if (recorded[name] != hash) {
+                std::cout << "Conan install invalidated: " << name << (recorded[name].empty() ? " is new" : " changed")
+                          << std::endl;
+            }
+        }
+    }
+
+    Trace::Phase phase("conan install");
+    auto installStart = std::chrono::steady_clock::now();
+    if (runConan({"install", ".", "--lockfile=" + lockfile,
+                  "--output-folder=" + fs::absolute(buildDir).lexically_normal().string(), "--build=missing",
+                  "-s", "build_type=" + buildType}) != 0) {
+        std::cerr << "Conan failed to install the dependencies in conan.lock" << std::endl;
+        return false;
+    }
+
+    createDirectory(buildDir + "/.cpp-manager");
+    std::ofstream out(buildDir + kDependencyStamp);
+    for (const auto& [name, hash] : dependencyInputs(buildDir, buildType)) {
+        out << name << " " << hash << "\n";
+    }
+    std::cout << "  conan install: " << std::fixed << std::setprecision(2) << secondsSince(installStart) << "s"
+              << std::endl;
+    return true;
+}
+
+bool ProjectManager::buildProject(const BuildOptions& options) {
+    if (!options.configs.empty()) {
+        return buildConfigurations(options);
+    }
+    std::string buildDir = projectName + "/" + options.buildDir;
+    createDirectory(buildDir);
+
+    auto [profile, march] = buildProfile(buildDir, options);
+    std::vector<std::string> definitions;
+    if (!profileDefinitions(profile, march, profile == "pgo" ? (pgoPhase.empty() ? "use" : pgoPhase) : "",
+                            definitions)) {
+        std::cerr << "Unknown build profile: " << profile << ". Use debug, release, release-lto, pgo or asan."
+                  << std::endl;
+        return false;
+    }
+    // Asking for pgo runs the whole cycle; a tree that is already pgo rebuilds with the profile it has
+    if (profile == "pgo" && !options.profile.empty() && pgoPhase.empty()) {
+        return buildWithProfileGuidance(options);
+    }
+    if (options.prepared ? !hasBuildProfiles() : !wireBuildProfiles()) {
+        std::cerr << "Warning: CMakeLists.txt has no place for the build profile section; only "
+                  << definitions.front().substr(2) << " is set." << std::endl;
+        definitions.resize(1);
+    }
+
+    unsigned jobs = options.jobs;
+    if (jobs == 0) {
+        jobs = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // An existing tree keeps its generator; CMake refuses to switch it in place. The farm takes over
+    // the compiles from Make, but Ninja would redo every command missing from its own log. C++20 module
+    // units only build with Ninja.
+    bool cxxModules = usesCxxModules();
+    std::string generator = cachedGenerator(buildDir);
+    if (generator.empty()) {
+        generator = commandExists("ninja") && (!options.farm || cxxModules) ? "Ninja" : "Unix Makefiles";
+    }
+    if (cxxModules && generator != "Ninja") {
+        std::cerr << "The C++20 module units (.cppm) under src/ need the Ninja generator (Ninja 1.11 or newer). "
+                  << (commandExists("ninja") ? "Remove " + options.buildDir + " to regenerate it with Ninja."
+                                             : "Install ninja first.")
+                  << std::endl;
+        return false;
+    }
+    bool farm = options.farm && generator != "Ninja";
+    if (options.farm && !farm) {
+        std::cerr << "Warning: --farm needs a Unix Makefiles tree and " << options.buildDir
+                  << " uses Ninja, so Ninja schedules this build." << std::endl;
+    }
+    // The farm's jobs and `analyze rebuild-cost --measure` come from compile_commands.json
+    definitions.push_back("-DCMAKE_EXPORT_COMPILE_COMMANDS=ON");
+
+    std::cout << std::fixed << std::setprecision(2);
+
+    if (!options.prepared) {
+        if (!installDependencies(buildDir, profileBuildType(profile), options.explain)) {
+            return false;
+        }
+        // Includes may have changed since the last create/delete module, requirements since the last add
+        updateTargetGraph();
+        wireDependencies(buildDir);
+    }
+    writeUnityBatches(buildDir, options);
+
+    auto inputs = configureInputs(buildDir, generator, definitions);
+    auto stale = staleConfigureInputs(buildDir, inputs);
+    if (options.explain) {
+        if (stale.empty()) {
+            std::cout << "Configure cache is up to date." << std::endl;
+        }
+        for (const auto& reason : stale) {
+            std::cout << "Configure cache invalidated: " << reason << std::endl;
+        }
+    }
+
+    // Per-TU time traces for --trace; the option stays on once set so later builds don't recompile
+    std::vector<std::string> configureCommand = {"cmake", "-S", fs::absolute(projectName).lexically_normal().string(),
+                                                 "-B", fs::absolute(buildDir).lexically_normal().string(),
+                                                 "-G", generator};
+    configureCommand.insert(configureCommand.end(), definitions.begin(), definitions.end());
+    // CMake only reads a toolchain file when the tree is first configured
+    bool firstConfigure = !fs::exists(buildDir + "/CMakeCache.txt");
+    if (fs::exists(buildDir + "/conan_toolchain.cmake") &&
+        (firstConfigure || !cacheEntries(buildDir)["CMAKE_TOOLCHAIN_FILE"].empty())) {
+        configureCommand.push_back("-DCMAKE_TOOLCHAIN_FILE=" + fs::absolute(buildDir + "/conan_toolchain.cmake").string());
+    }
+    if (Trace::instance().enabled()) {
+        configureCommand.push_back("-DCPP_MANAGER_TIME_TRACE=ON");
+        if (stale.empty() && cacheEntries(buildDir)["CPP_MANAGER_TIME_TRACE"] != "ON") {
+            stale.push_back("--trace needs -DCPP_MANAGER_TIME_TRACE=ON");
+        }
+    }
+
+    if (!stale.empty()) {
+        Trace::Phase phase("configure");
+        auto configureStart = std::chrono::steady_clock::now();
+        if (executeCommand(configureCommand, buildDir) != 0) {
+            std::cerr << "CMake configuration failed." << std::endl;
+            return false;
+        }
+        // The toolchain file may only appear after the first configure, so hash again
+        writeConfigureManifest(buildDir, configureInputs(buildDir, generator, definitions));
+        std::cout << "  configure: " << secondsSince(configureStart) << "s" << std::endl;
+    } else {
+        refreshGeneratorStamps(buildDir, generator);
+        std::cout << "  configure: skipped (up to date)" << std::endl;
+    }
+
+    // Only count cache traffic when this tree actually compiles through a cache launcher
+    auto entries = cacheEntries(buildDir);
+    std::string cacheProgram;
+    for (const char* key : {"CMAKE_CXX_COMPILER_LAUNCHER", "CCACHE_PROGRAM", "SCCACHE_PROGRAM"}) {
+        const std::string& value = entries[key];
+        if (!value.empty() && value.find("-NOTFOUND") == std::string::npos) {
+            cacheProgram = fs::path(value).filename().string();
+            break;
+        }
+    }
+    if (cacheProgram != "ccache" && cacheProgram != "sccache") {
+        cacheProgram.clear();
+    }
+    std::pair<long, long> cacheBefore;
+    if (!cacheProgram.empty()) {
+        cacheBefore = compilerCacheCounters(cacheProgram);
+    }
+
+    Trace::Phase phase("compile+link");
+    auto buildStart = std::chrono::steady_clock::now();
+    auto buildStartFile = fs::file_time_type::clock::now();
+    int64_t buildStartUs = Trace::instance().nowUs();
+    // Under a jobserver (`build --configs`, or a make recipe) -j would make the build tool ignore its tokens
+    const char* makeFlags = getenv("MAKEFLAGS");
+    bool jobserver = options.jobs == 0 && makeFlags && std::string(makeFlags).find("--jobserver-auth=") != std::string::npos;
+    std::vector<std::string> buildCommand = {"cmake", "--build", buildDir};
+    if (!jobserver) {
+        buildCommand.insert(buildCommand.end(), {"--parallel", std::to_string(jobs)});
+    }
+    if ((farm && !buildWithFarm(buildDir, jobs)) || executeCommand(buildCommand) != 0) {
+        std::cerr << "Build failed." << std::endl;
+        return false;
+    }
+    double buildSeconds = secondsSince(buildStart);
+    Trace::instance().mergeTimeTraces(buildDir, buildStartFile);
+
+    if (generator == "Ninja") {
+        reportNinjaPhases(buildDir, buildStartFile);
+        Trace::instance().mergeNinjaLog(buildDir, buildStartFile, buildStartUs);
+    } else {
+        std::cout << "  compile+link: " << buildSeconds << "s" << std::endl;
+    }
+
+    if (!cacheProgram.empty()) {
+        auto cacheAfter = compilerCacheCounters(cacheProgram);
+        long hits = cacheAfter.first - cacheBefore.first;
+        long misses = cacheAfter.second - cacheBefore.second;
+        std::cout << "  " << cacheProgram << ": " << hits << " hits, " << misses << " misses";
+        if (hits + misses > 0) {
+            std::cout << " (" << 100.0 * hits / (hits + misses) << "% hit rate)";
+        }
+        std::cout << std::endl;
+    }
+
+    createFile(buildDir + kBuildProfileFile, profile + "\n" + march + "\n");
+    std::cout << "Project built successfully with " << (jobserver ? "shared job tokens" : std::to_string(jobs) + " jobs")
+              << " (" << generator << (farm ? " and compile farm" : "") << ", " << profile
+              << (pgoPhase.empty() ? "" : " " + pgoPhase) << " profile)!" << std::endl;
+    return true;
+}
+
+bool ProjectManager::buildConfigurations(const BuildOptions& options) {
+    unsigned jobs = options.jobs ? options.jobs : std::max(1u, std::thread::hardware_concurrency());
+    for (const auto& config : options.configs) {
+        std::vector<std::string> definitions;
+        if (!profileDefinitions(config, "", "", definitions) || config == "pgo") {
+            std::cerr << "Cannot build configuration " << config << " alongside others. Use debug, release, "
+                      << "release-lto or asan." << std::endl;
+            return false;
+        }
+    }
+
+    // Steps that write into the project itself happen once, before the trees race for them; the
+    // builds of the trees are told to skip them
+    updateTargetGraph();
+    wireBuildProfiles();
+
+    // The Conan cache is not safe for concurrent use: install serially, one build_type after the other.
+    // Packages are resolved and built once per build_type; further trees only get their generated files.
+    std::vector<std::string> configs = options.configs;
+    std::stable_sort(configs.begin(), configs.end(), [](const std::string& a, const std::string& b) {
+        return profileBuildType(a) < profileBuildType(b);
+    });
+    for (const auto& config : configs) {
+        std::string buildDir = projectName + "/build-" + config;
+        createDirectory(buildDir);
+        if (!installDependencies(buildDir, profileBuildType(config), options.explain)) {
+            return false;
+        }
+    }
+    // Every build_type gets the same package and target names
+    wireDependencies(projectName + "/build-" + configs.front());
+
+    // One token pipe for every Make tree: each build holds its implicit token, the rest are shared, so
+    // the trees never run more than `jobs` compilers together. Ninja and the compile farm cannot read the
+    // pipe; their trees get an even share of the jobs instead.
+    int tokens[2] = {-1, -1};
+    if (pipe(tokens) != 0) {
+        std::cerr << "Failed to create the job token pipe" << std::endl;
+        return false;
+    }
+    std::string tokenBytes(jobs > configs.size() ? jobs - configs.size() : 0, '+');
+    if (!tokenBytes.empty() && write(tokens[1], tokenBytes.data(), tokenBytes.size()) != static_cast<ssize_t>(tokenBytes.size())) {
+        std::cerr << "Failed to fill the job token pipe" << std::endl;
+    }
+    unsigned share = std::max<unsigned>(1, jobs / configs.size());
+
+    char self[4096];
+    ssize_t length = readlink("/proc/self/exe", self, sizeof(self) - 1);
+    std::string program = length > 0 ? std::string(self, static_cast<size_t>(length)) : "cpp-manager";
+    std::vector<ProcessSpec> specs;
+    for (const auto& config : configs) {
+        ProcessSpec spec;
+        spec.argv = {program, "build", "--profile", config, "--build-dir", "build-" + config, "--prepared"};
+        // A daemon would build the trees one after the other
+        spec.environment["CPP_MANAGER_NO_DAEMON"] = "1";
+        std::string generator = cachedGenerator(projectName + "/build-" + config);
+        if (generator.empty()) {
+            generator = commandExists("ninja") && !options.farm ? "Ninja" : "Unix Makefiles";
+        }
+        // Neither Ninja nor the compile farm reads job tokens
+        if (generator == "Ninja" || options.farm) {
+            spec.argv.insert(spec.argv.end(), {"--jobs", std::to_string(share)});
+        } else {
+            spec.environment["MAKEFLAGS"] = "-j" + std::to_string(jobs) + " --jobserver-auth=" +
+                                            std::to_string(tokens[0]) + "," + std::to_string(tokens[1]);
+        }
+        if (options.explain) {
+            spec.argv.push_back("--explain");
+        }
+        if (options.farm) {
+            spec.argv.push_back("--farm");
+        }
+        if (options.unity) {
+            spec.argv.insert(spec.argv.end(), {"--unity", "--batch-size", std::to_string(options.unityBatchSize)});
+            for (const auto& exclude : options.unityExclude) {
+                spec.argv.insert(spec.argv.end(), {"--exclude", exclude});
+            }
+        }
+        spec.workingDirectory = projectName;
+        spec.stdoutMode = ProcessOutput::Capture;
+        spec.stderrMode = ProcessOutput::MergeIntoStdout;
+        specs.push_back(spec);
+    }
+
+    std::cout << "Building " << configs.size() << " configurations with " << jobs << " jobs in total" << std::endl;
+    auto start = std::chrono::steady_clock::now();
+    size_t failed = 0;
+    Trace::Phase phase("configs");
+    Process::runAll(specs, static_cast<unsigned>(specs.size()), [&](size_t index, const ProcessResult& result) {
+        std::cout << "==> " << configs[index] << " (build-" << configs[index] << ")\n" << result.out;
+        std::cout << "==> " << configs[index] << ": " << (result.exitCode == 0 ? "built" : "FAILED") << " in "
+                  << std::fixed << std::setprecision(2) << result.seconds << "s" << std::endl;
+        failed += result.exitCode != 0;
+    });
+    close(tokens[0]);
+    close(tokens[1]);
+
+    std::cout << configs.size() - failed << "/" << configs.size() << " configurations built in " << std::fixed
+              << std::setprecision(2) << secondsSince(start) << "s" << std::endl;
+    return failed == 0;
+}
+
+// Compiles and links a configured Makefiles tree on a CompileFarm. The build tool runs afterwards for
+// whatever else the tree has and finds these outputs up to date.
+bool ProjectManager::buildWithFarm(const std::string& buildDir, unsigned jobs) {
+    JsonValue commands;
+    if (!JsonValue::parseFile(buildDir + "/compile_commands.json", commands) || !commands.isArray()) {
+        std::cerr << "No compile_commands.json in " << buildDir << "; cannot schedule the compiles." << std::endl;
+        return false;
+    }
+    fs::path root = fs::absolute(buildDir).lexically_normal();
+
+    // Per output "<seconds> <command hash> <path>", averaged over the runs that produced it
+    std::map<std::string, std::pair<double, std::string>> learned;
+    {
+        std::ifstream in(buildDir + kFarmTimes);
+        double seconds;
+        std::string hash, name;
+        while (in >> seconds >> hash && std::getline(in >> std::ws, name)) {
+            learned[name] = {seconds, hash};
+        }
+    }
+
+    std::vector<FarmJob> all;
+    std::vector<std::string> outputs;                   // absolute path of each job's output
+    std::vector<std::vector<std::string>> inputFiles;   // files the output must be newer than
+    std::map<std::string, size_t> byOutput;
+    for (const auto& entry : commands.items()) {
+        FarmJob job;
+        job.workingDirectory = entry["directory"].asString();
+        if (entry.contains("arguments")) {
+            for (const auto& arg : entry["arguments"].items()) {
+                job.argv.push_back(arg.asString());
+            }
+        } else {
+            job.argv = splitCommand(entry["command"].asString());
+        }
+        auto output = std::find(job.argv.begin(), job.argv.end(), "-o");
+        if (output == job.argv.end() || output + 1 == job.argv.end()) {
+            continue;
+        }
+        std::string object = *(output + 1);
+        // The dependency file the build tool writes itself, so it keeps tracking headers
+        job.argv.insert(output, {"-MD", "-MT", object, "-MF", object + ".d"});
+        std::string path = (fs::path(job.workingDirectory) / object).lexically_normal().string();
+        job.name = fs::path(path).lexically_relative(root).string();
+        byOutput[path] = all.size();
+        outputs.push_back(path);
+        inputFiles.push_back({});
+        all.push_back(job);
+    }
+    size_t compileCount = all.size();
+
+    // Objects built with a precompiled header need it first
+    for (size_t i = 0; i < compileCount; ++i) {
+        const auto& argv = all[i].argv;
+        for (size_t k = 0; k + 1 < argv.size(); ++k) {
+            auto header = byOutput.find(argv[k] == "-include" ? argv[k + 1] + ".gch" : "");
+            if (header != byOutput.end() && header->second != i) {
+                all[i].dependencies.push_back(header->second);
+            }
+        }
+    }
+
+    // Links from <dir>/CMakeFiles/<target>.dir/link.txt; CMake's own try-compile trees are skipped
+    std::vector<std::vector<std::string>> linkWords;
+    std::string archiver = fs::path(cacheEntries(buildDir)["CMAKE_AR"]).filename().string();
+    auto isArchiver = [&](const std::string& program) {
+        std::string name = fs::path(program).filename().string();
+        return name == archiver || name == "ar" || name == "llvm-ar" || name == "gcc-ar";
+    };
+    std::error_code ec;
+    for (auto it = fs::recursive_directory_iterator(root, ec); !ec && it != fs::recursive_directory_iterator();
+         it.increment(ec)) {
+        fs::path script = it->path();
+        fs::path relative = script.lexically_relative(root);
+        if (script.filename() != "link.txt" || std::count(relative.begin(), relative.end(), "CMakeFiles") != 1 ||
+            script.parent_path().parent_path().filename() != "CMakeFiles") {
+            continue;
+        }
+        fs::path directory = script.parent_path().parent_path().parent_path();
+        std::ifstream in(script);
+        std::vector<std::string> words;
+        std::string output, line;
+        while (std::getline(in, line)) {
+            auto lineWords = splitCommand(line);
+            auto flag = std::find(lineWords.begin(), lineWords.end(), "-o");
+            if (output.empty() && flag != lineWords.end() && flag + 1 != lineWords.end()) {
+                output = *(flag + 1);
+            } else if (output.empty() && lineWords.size() > 2 && isArchiver(lineWords[0])) {
+                output = lineWords[2]; // ar <operation> <archive> <objects>...
+            }
+            words.insert(words.end(), lineWords.begin(), lineWords.end());
+        }
+        if (output.empty()) {
+            continue;
+        }
+        FarmJob job;
+        job.workingDirectory = directory.string();
+        job.argv = {"cmake", "-E", "cmake_link_script", script.lexically_relative(directory).string()};
+        job.link = true;
+        std::string path = (directory / output).lexically_normal().string();
+        job.name = fs::path(path).lexically_relative(root).string();
+        byOutput[path] = all.size();
+        outputs.push_back(path);
+        inputFiles.push_back({script.string()});
+        linkWords.push_back(words);
+        all.push_back(job);
+    }
+    for (size_t i = compileCount; i < all.size(); ++i) {
+        for (const auto& word : linkWords[i - compileCount]) {
+            std::string path = (fs::path(all[i].workingDirectory) / word).lexically_normal().string();
+            auto input = byOutput.find(path);
+            if (input != byOutput.end() && input->second != i) {
+                all[i].dependencies.push_back(input->second);
+                inputFiles[i].push_back(path);
+            }
+        }
+    }
+
+    // A job runs when its output is older than an input, its command changed, or a job it needs runs
+    std::vector<std::string> hashes;
+    for (const auto& job : all) {
+        std::string joined = job.workingDirectory;
+        for (const auto& arg : job.argv) {
+            joined += '\0' + arg;
+        }
+        hashes.push_back(hashContent(joined));
+    }
+    std::vector<int> dirty(all.size(), -1);
+    std::function<bool(size_t)> isDirty = [&](size_t i) {
+        if (dirty[i] >= 0) {
+            return dirty[i] == 1;
+        }
+        dirty[i] = 0;
+        bool stale = false;
+        for (size_t dependency : all[i].dependencies) {
+            stale = isDirty(dependency) || stale;
+        }
+        auto known = learned.find(all[i].name);
+        stale = stale || (known != learned.end() && known->second.second != hashes[i]);
+        std::vector<std::string> inputs = inputFiles[i];
+        if (!all[i].link && !dependencyFileInputs(outputs[i] + ".d", inputs)) {
+            stale = true;
+        }
+        std::error_code timeError;
+        auto built = fs::last_write_time(outputs[i], timeError);
+        stale = stale || timeError;
+        for (size_t k = 0; !stale && k < inputs.size(); ++k) {
+            fs::path input = fs::path(all[i].workingDirectory) / inputs[k];
+            auto modified = fs::last_write_time(input, timeError);
+            stale = timeError || modified > built;
+        }
+        dirty[i] = stale ? 1 : 0;
+        return stale;
+    };
+
+    // Unknown durations are estimated as the average of the known ones of the same kind
+    double knownSeconds[2] = {0, 0};
+    size_t knownCount[2] = {0, 0};
+    for (size_t i = 0; i < all.size(); ++i) {
+        auto known = learned.find(all[i].name);
+        if (known != learned.end()) {
+            knownSeconds[all[i].link] += known->second.first;
+            ++knownCount[all[i].link];
+        }
+    }
+    std::vector<FarmJob> farmJobs;
+    std::vector<size_t> farmIndex(all.size(), SIZE_MAX), original;
+    for (size_t i = 0; i < all.size(); ++i) {
+        if (!isDirty(i)) {
+            continue;
+        }
+        FarmJob job = all[i];
+        auto known = learned.find(job.name);
+        job.estimate = known != learned.end() ? known->second.first
+                       : knownCount[job.link] ? knownSeconds[job.link] / knownCount[job.link]
+                                              : 1.0;
+        farmIndex[i] = farmJobs.size();
+        original.push_back(i);
+        farmJobs.push_back(job);
+    }
+    for (auto& job : farmJobs) {
+        std::vector<size_t> dependencies;
+        for (size_t dependency : job.dependencies) {
+            if (farmIndex[dependency] != SIZE_MAX) {
+                dependencies.push_back(farmIndex[dependency]);
+            }
+        }
+        job.dependencies = dependencies;
+    }
+    size_t upToDate = all.size() - farmJobs.size();
+    if (farmJobs.empty()) {
+        std::cout << "  farm: " << upToDate << " outputs up to date" << std::endl;
+        return true;
+    }
+    for (const auto& job : farmJobs) {
+        // ar adds to an existing archive
+        if (job.link && fs::path(job.name).extension() == ".a") {
+            fs::remove(root / job.name, ec);
+        }
+    }
+
+    auto paths = CompileFarm::criticalPaths(farmJobs);
+    double criticalPath = *std::max_element(paths.begin(), paths.end());
+    size_t done = 0, links = 0;
+    for (const auto& job : farmJobs) {
+        links += job.link;
+    }
+    auto start = std::chrono::steady_clock::now();
+    CompileFarm farm(jobs);
+    Trace& trace = Trace::instance();
+    std::string phase = trace.currentPhase();
+    bool succeeded = farm.run(farmJobs, [&](size_t index, const ProcessResult& result) {
+        const FarmJob& job = farmJobs[index];
+        std::cout << "[" << ++done << "/" << farmJobs.size() << "] " << (job.link ? "link " : "compile ") << job.name
+                  << " (" << result.seconds << "s)" << std::endl;
+        std::cout << result.out << std::flush;
+        if (result.exitCode == 0) {
+            auto known = learned.find(job.name);
+            bool same = known != learned.end() && known->second.second == hashes[original[index]];
+            learned[job.name] = {same ? (known->second.first + result.seconds) / 2 : result.seconds,
+                                 hashes[original[index]]};
+        } else {
+            std::cerr << "FAILED: " << job.name << std::endl;
+        }
+
+        TraceSpan span;
+        span.name = (job.link ? "link " : "compile ") + job.name;
+        span.phase = phase;
+        span.process = "farm";
+        span.endUs = trace.nowUs();
+        span.startUs = span.endUs - static_cast<int64_t>(result.seconds * 1e6);
+        span.exitCode = result.exitCode;
+        span.maxRssKb = result.maxRssKb;
+        trace.record(span);
+    });
+
+    std::ostringstream times;
+    times << std::fixed << std::setprecision(6);
+    for (const auto& [name, entry] : learned) {
+        times << entry.first << " " << entry.second << " " << name << "\n";
+    }
+    createFile(buildDir + kFarmTimes, times.str());
+
+    std::cout << "  farm: " << farmJobs.size() - links << " compiles and " << links << " links on "
+              << farm.workerCount() << " workers in " << secondsSince(start) << "s (critical path " << criticalPath
+              << "s estimated), " << upToDate << " up to date" << std::endl;
+    return succeeded;
+}
+
+std::pair<std::string, std::string> ProjectManager::buildProfile(const std::string& buildDir,
+                                                                 const BuildOptions& options) {
+    std::string profile = options.profile, march = options.march;
+    if (profile.empty()) {
+        // Keep what the tree was last built with, so a plain `build` stays incremental
+        std::ifstream recorded(buildDir + kBuildProfileFile);
+        std::string recordedMarch;
+        if (std::getline(recorded, profile) && std::getline(recorded, recordedMarch) && march.empty()) {
+            return {profile, recordedMarch};
+        }
+    }
+    if (profile.empty()) {
+        profile = "release";
+    }
+    if (march.empty() && (profile == "release-lto" || profile == "pgo")) {
+        march = "native";
+    }
+    return {profile, march};
+}
+
+bool ProjectManager::hasBuildProfiles() {
+    std::ifstream in(projectName + "/CMakeLists.txt");
+    std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    return content.find(kBuildProfiles) != std::string::npos;
+}
+
+bool ProjectManager::wireBuildProfiles() {
+    std::string cmakePath = projectName + "/CMakeLists.txt";
+    std::ifstream in(cmakePath);
+    std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+    if (content.find(kBuildProfiles) != std::string::npos) {
+        return true;
+    }
+
+    // A section from an older cpp-manager is replaced in place; it ends with the PGO block
+    size_t section = content.find("# Build profiles, selected with");
+    size_t pgoBlock = content.find("\nif(CPP_MANAGER_PGO STREQUAL", section);
+    size_t sectionEnd = content.find("\nendif()\n", pgoBlock);
+    if (section != std::string::npos && pgoBlock != std::string::npos && sectionEnd != std::string::npos) {
+        content.replace(section, sectionEnd + 9 - section, kBuildProfiles);
+        createFile(cmakePath, content);
+        std::cout << "Updated the build profile section in " << cmakePath << std::endl;
+        return true;
+    }
+
+    // Compile options and CMAKE_INTERPROCEDURAL_OPTIMIZATION only reach targets defined after them
+    size_t insertAt = std::string::npos;
+    for (const char* anchor : {"include_directories(", "# BEGIN cpp-manager targets", "add_library(",
+                               "add_executable("}) {
+        size_t found = content.find(anchor);
+        if (found != std::string::npos) {
+            insertAt = content.rfind('\n', found);
+            insertAt = insertAt == std::string::npos ? 0 : insertAt + 1;
+            break;
+        }
+    }
+    if (insertAt == std::string::npos) {
+        return false;
+    }
+    content.insert(insertAt, std::string(kBuildProfiles) + "\n");
+    createFile(cmakePath, content);
+    std::cout << "Added the build profile section to " << cmakePath << std::endl;
+    return true;
+}
+
+bool ProjectManager::buildWithProfileGuidance(const BuildOptions& options) {
+    std::string buildDir = projectName + "/" + options.buildDir;
+    std::string profileDir = buildDir + "/pgo";
+
+    // Counters from an older build would not match the instrumented objects
+    std::error_code ec;
+    fs::remove_all(profileDir, ec);
+    auto start = std::chrono::steady_clock::now();
+
+    pgoPhase = "generate";
+    bool ok;
+    {
+        Trace::Phase phase("pgo-generate");
+        std::cout << "PGO 1/3: instrumented build" << std::endl;
+        ok = buildProject(options);
+    }
+    if (ok) {
+        Trace::Phase phase("pgo-train");
+        std::cout << "PGO 2/3: training run" << std::endl;
+        ok = runTrainingWorkload(options, buildDir);
+    }
+
+    // Clang writes raw profiles that have to be merged into one .profdata; GCC reads its .gcda files directly
+    std::string compiler = fs::path(cxxCompiler(buildDir)).filename().string();
+    if (ok && compiler.find("clang") != std::string::npos) {
+        std::string version = compiler.find('-') != std::string::npos ? compiler.substr(compiler.find('-')) : "";
+        std::string profdata = commandExists("llvm-profdata" + version) ? "llvm-profdata" + version : "llvm-profdata";
+        std::vector<std::string> merge = {profdata, "merge", "-output=" + profileDir + "/default.profdata"};
+        for (const auto& entry : fs::directory_iterator(profileDir, ec)) {
+            if (entry.path().extension() == ".profraw") {
+                merge.push_back(entry.path().string());
+            }
+        }
+        ok = merge.size() > 3 && executeCommand(merge) == 0;
+    }
+    if (ok && (fs::is_empty(profileDir, ec) || ec)) {
+        std::cerr << "The training run wrote no profile data to " << profileDir << std::endl;
+        ok = false;
+    }
+
+    if (ok) {
+        pgoPhase = "use";
+        Trace::Phase phase("pgo-use");
+        std::cout << "PGO 3/3: optimized build with the training profile" << std::endl;
+        ok = buildProject(options);
+    }
+    pgoPhase.clear();
+    if (ok) {
+        std::cout << "Profile-guided build finished in " << std::fixed << std::setprecision(2) << secondsSince(start)
+                  << "s" << std::endl;
+    }
+    return ok;
+}
+
+bool ProjectManager::runTrainingWorkload(const BuildOptions& options, const std::string& buildDir) {
+    if (!options.trainCommand.empty()) {
+        std::vector<std::string> argv = splitCommand(options.trainCommand);
+        if (argv.empty() || executeCommand(argv, projectName) != 0) {
+            std::cerr << "Training command failed: " << options.trainCommand << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    auto benchmarks = benchmarkExecutables(buildDir);
+    if (!benchmarks.empty()) {
+        for (const auto& benchmark : benchmarks) {
+            if (executeCommand({benchmark}) != 0) {
+                std::cerr << "Training benchmark failed: " << benchmark << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+    if (!listTests(buildDir).empty()) {
+        // Failing tests still exercise the code; their counters are as good as any
+        if (executeCommand({"ctest", "--output-on-failure"}, buildDir) != 0) {
+            std::cerr << "Warning: some training tests failed" << std::endl;
+        }
+        return true;
+    }
+    std::cerr << "The pgo profile needs a training workload: add benchmarks (`create bench`) or tests, or pass "
+              << "--train <command>." << std::endl;
+    return false;
+}
+
+bool ProjectManager::commandExists(const std::string& program) {
+    return !Process::findExecutable(program).empty();
+}
+
+std::string ProjectManager::conanProgram() {
+    for (const std::string& venvConan : {projectName + "/manager/bin/conan", storeDirectory() + "/venv/bin/conan"}) {
+        if (fs::exists(venvConan)) {
+            return fs::absolute(venvConan).string();
+        }
+    }
+    return "conan";
+}
+
+std::string ProjectManager::conanHome() {
+    // Packages are built once per reference, revision and settings hash and reused by every project.
+    // An explicit CONAN_HOME still wins.
+    const char* home = getenv("CONAN_HOME");
+    return home ? std::string(home) : storeDirectory() + "/conan";
+}
+
+std::string ProjectManager::conanProfilePath() {
+    const char* profile = getenv("CONAN_DEFAULT_PROFILE");
+    std::string profilePath = profile ? std::string(profile) : "default";
+    return fs::path(profilePath).is_relative() ? conanHome() + "/profiles/" + profilePath : profilePath;
+}
+
+int ProjectManager::runConan(const std::vector<std::string>& args) {
+    ProcessSpec spec;
+    spec.argv = {conanProgram()};
+    spec.argv.insert(spec.argv.end(), args.begin(), args.end());
+    spec.workingDirectory = projectName;
+    spec.environment["CONAN_HOME"] = conanHome();
+    return Process::run(spec).exitCode;
+}
+
+bool ProjectManager::collectGarbage(const std::string& maxAge) {
+    std::string packages = conanHome() + "/p";
+    uintmax_t before = directorySize(packages);
+
+    // Conan records when each recipe and binary was last used; drop what no project touched recently
+    if (runConan({"remove", "*", "--lru=" + maxAge, "-c"}) != 0) {
+        std::cerr << "Conan failed to remove packages unused for " << maxAge << std::endl;
+        return false;
+    }
+    // Build and source folders are only needed while a package is being built
+    if (runConan({"cache", "clean", "*"}) != 0) {
+        std::cerr << "Conan failed to clean its build folders" << std::endl;
+        return false;
+    }
+
+    uintmax_t after = directorySize(packages);
+    std::cout << "Package store: " << (before - std::min(before, after)) / (1024 * 1024) << " MB freed, "
+              << after / (1024 * 1024) << " MB in use (" << conanHome() << ")" << std::endl;
+    return true;
+}
+
+std::map<std::string, std::string> ProjectManager::cacheEntries(const std::string& buildDir) {
+    std::map<std::string, std::string> entries;
+    std::ifstream cache(buildDir + "/CMakeCache.txt");
+    std::string line;
+    while (std::getline(cache, line)) {
+        size_t colon = line.find(':');
+        size_t equals = line.find('=');
+        if (line[0] != '#' && line[0] != '/' && colon != std::string::npos && equals != std::string::npos && colon < equals) {
+            entries[line.substr(0, colon)] = line.substr(equals + 1);
+        }
+    }
+    return entries;
+}
+
+std::string ProjectManager::cachedGenerator(const std::string& buildDir) {
+    std::ifstream cache(buildDir + "/CMakeCache.txt");
+    std::string line;
+    const std::string key = "CMAKE_GENERATOR:INTERNAL=";
+    while (std::getline(cache, line)) {
+        if (line.compare(0, key.size(), key) == 0) {
+            return line.substr(key.size());
+        }
+    }
+    return "";
+}
+
+std::map<std::string, std::string> ProjectManager::configureInputs(const std::string& buildDir,
+                                                                   const std::string& generator,
+                                                                   const std::vector<std::string>& definitions) {
+    std::map<std::string, std::string> inputs;
+    inputs["generator"] = hashContent(generator);
+    std::string profile;
+    for (const auto& definition : definitions) {
+        profile += definition + "\n";
+    }
+    inputs["build profile"] = hashContent(profile);
+    inputs["CMakeLists.txt"] = hashFile(projectName + "/CMakeLists.txt");
+    inputs["conanfile.txt"] = hashFile(projectName + "/conanfile.txt");
+
+    // Toolchain files: the Conan one, whatever the cache points at, and project-local modules
+    inputs["toolchain:conan_toolchain.cmake"] = hashFile(buildDir + "/conan_toolchain.cmake");
+    std::ifstream cache(buildDir + "/CMakeCache.txt");
+    std::string line;
+    while (std::getline(cache, line)) {
+        if (line.rfind("CMAKE_TOOLCHAIN_FILE:", 0) == 0) {
+            std::string toolchain = line.substr(line.find('=') + 1);
+            inputs["toolchain:" + toolchain] = hashFile(toolchain);
+        }
+    }
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(projectName + "/cmake", ec)) {
+        if (entry.path().extension() == ".cmake") {
+            inputs["toolchain:cmake/" + entry.path().filename().string()] = hashFile(entry.path().string());
+        }
+    }
+
+    // Globbed source lists only change when files are added, removed or renamed
+    std::vector<std::string> files;
+    for (const char* dir : {"src", "include"}) {
+        for (auto it = fs::recursive_directory_iterator(projectName + "/" + dir, ec);
+             !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            if (it->is_regular_file()) {
+                files.push_back(fs::relative(it->path(), projectName).string());
+            }
+        }
+    }
+    std::sort(files.begin(), files.end());
+    std::string fileList;
+    for (const auto& file : files) {
+        fileList += file + "\n";
+    }
+    inputs["source file list"] = hashContent(fileList);
+    inputs["unity batches"] = hashFile(buildDir + "/unity/sources.cmake");
+
+    return inputs;
+}
+
+std::vector<std::string> ProjectManager::staleConfigureInputs(const std::string& buildDir,
+                                                              const std::map<std::string, std::string>& inputs) {
+    if (!fs::exists(buildDir + "/CMakeCache.txt")) {
+        return {"build tree has not been configured yet"};
+    }
+
+    std::map<std::string, std::string> recorded;
+    std::ifstream manifest(buildDir + kConfigureManifest);
+    if (!manifest) {
+        return {"no configure manifest in " + buildDir};
+    }
+    std::string line;
+    while (std::getline(manifest, line)) {
+        size_t space = line.rfind(' ');
+        if (space != std::string::npos) {
+            recorded[line.substr(0, space)] = line.substr(space + 1);
+        }
+    }
+
+    std::vector<std::string> stale;
+    for (const auto& [name, hash] : inputs) {
+        auto it = recorded.find(name);
+        if (it == recorded.end()) {
+            stale.push_back(name + " is new");
+        } else if (it->second != hash) {
+            stale.push_back(name + " changed");
+        }
+    }
+    for (const auto& [name, hash] : recorded) {
+        if (inputs.find(name) == inputs.end()) {
+            stale.push_back(name + " was removed");
+        }
+    }
+    return stale;
+}
+
+void ProjectManager::writeConfigureManifest(const std::string& buildDir,
+                                            const std::map<std::string, std::string>& inputs) {
+    std::ofstream manifest(buildDir + kConfigureManifest);
+    for (const auto& [name, hash] : inputs) {
+        manifest << name << " " << hash << "\n";
+    }
+}
+
+void ProjectManager::writeUnityBatches(const std::string& buildDir, const BuildOptions& options) {
+    std::string unityDir = buildDir + "/unity";
+    if (!options.unity) {
+        // Back to one TU per file; the manifest sees sources.cmake disappear and reconfigures
+        std::error_code ec;
+        fs::remove_all(unityDir, ec);
+        return;
+    }
+    createDirectory(unityDir);
+
+    std::vector<fs::path> batched, isolated, moduleUnits;
+    std::error_code ec;
+    for (auto it = fs::recursive_directory_iterator(projectName + "/src", ec);
+         !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        fs::path path = fs::absolute(it->path()).lexically_normal();
+        if (it->is_regular_file() && it->path().extension() == ".cppm") {
+            moduleUnits.push_back(path);
+        }
+        if (!it->is_regular_file() || it->path().extension() != ".cpp") {
+            continue;
+        }
+        std::string relative = fs::relative(it->path(), projectName + "/src").string();
+        bool excluded = std::any_of(options.unityExclude.begin(), options.unityExclude.end(),
+                                    [&](const std::string& name) {
+                                        return name == relative || name == it->path().stem().string();
+                                    });
+        // A module implementation unit must start its own translation unit
+        bool moduleUnit = false;
+        std::ifstream in(path);
+        for (std::string line; !moduleUnit && std::getline(in, line);) {
+            moduleUnit = !declaredModule(line).empty();
+        }
+        if (moduleUnit) {
+            moduleUnits.push_back(path);
+        }
+        (excluded || moduleUnit ? isolated : batched).push_back(path);
+    }
+    // Stable batches keep unchanged batch files untouched between runs
+    std::sort(batched.begin(), batched.end());
+    std::sort(isolated.begin(), isolated.end());
+    std::sort(moduleUnits.begin(), moduleUnits.end());
+
+    FileBatch files;
+    unsigned batchSize = std::max(1u, options.unityBatchSize);
+    std::string sourcesCmake = "set(CPP_MANAGER_SOURCES\n";
+    size_t batchCount = (batched.size() + batchSize - 1) / batchSize;
+    for (size_t batch = 0; batch < batchCount; ++batch) {
+        std::string content = "// Generated by cpp-manager build --unity. Do not edit.\n";
+        for (size_t i = batch * batchSize; i < std::min(batched.size(), (batch + 1) * batchSize); ++i) {
+            content += "#include \"" + batched[i].string() + "\"\n";
+        }
+
+        fs::path batchPath = fs::absolute(unityDir + "/unity_" + std::to_string(batch) + ".cpp").lexically_normal();
+        files.write(batchPath.string(), content);
+        sourcesCmake += "    \"" + batchPath.string() + "\"\n";
+    }
+    for (const auto& path : isolated) {
+        sourcesCmake += "    \"" + path.string() + "\"\n";
+    }
+    sourcesCmake += ")\n";
+    if (!moduleUnits.empty()) {
+        // Interface units go into the CXX_MODULES file set; no module unit may start with a forced #include
+        std::string interfaceUnits, implementationUnits;
+        for (const auto& path : moduleUnits) {
+            (path.extension() == ".cppm" ? interfaceUnits : implementationUnits) += "    \"" + path.string() + "\"\n";
+        }
+        sourcesCmake += "set(CPP_MANAGER_MODULE_UNITS\n" + interfaceUnits + ")\n";
+        sourcesCmake += "set_source_files_properties(\n" + interfaceUnits + implementationUnits +
+                        "    PROPERTIES SKIP_PRECOMPILE_HEADERS ON)\n";
+    }
+
+    // Drop batch files left over from a run with more batches
+    for (size_t batch = batchCount; fs::exists(unityDir + "/unity_" + std::to_string(batch) + ".cpp"); ++batch) {
+        deleteFile(unityDir + "/unity_" + std::to_string(batch) + ".cpp");
+    }
+
+    // Unchanged batches are not rewritten, so their objects stay up to date
+    files.write(unityDir + "/sources.cmake", sourcesCmake);
+    files.commit();
+    std::cout << "  unity: " << batched.size() << " files in " << batchCount << " batches, "
+              << isolated.size() << " isolated" << std::endl;
+}
+
+void ProjectManager::refreshGeneratorStamps(const std::string& buildDir, const std::string& generator) {
+    // The generated build system re-runs CMake on its own when an input's mtime moves, even if the
+    // content is identical. The manifest says nothing changed, so mark its outputs as fresh.
+    std::vector<std::string> outputs;
+    if (generator == "Ninja") {
+        outputs.push_back("build.ninja");
+    } else {
+        std::ifstream makefileCmake(buildDir + "/CMakeFiles/Makefile.cmake");
+        std::string line;
+        bool inOutputs = false;
+        while (std::getline(makefileCmake, line)) {
+            if (line.rfind("set(CMAKE_MAKEFILE_OUTPUTS", 0) == 0 || line.rfind("set(CMAKE_MAKEFILE_PRODUCTS", 0) == 0) {
+                inOutputs = true;
+            } else if (inOutputs && line.find(')') != std::string::npos) {
+                inOutputs = false;
+            } else if (inOutputs) {
+                size_t open = line.find('"');
+                size_t close = line.rfind('"');
+                if (open != std::string::npos && close > open) {
+                    outputs.push_back(line.substr(open + 1, close - open - 1));
+                }
+            }
+        }
+    }
+
+    auto now = fs::file_time_type::clock::now();
+    for (const auto& output : outputs) {
+        std::error_code ec;
+        fs::path path = fs::path(output).is_absolute() ? fs::path(output) : fs::path(buildDir) / output;
+        if (fs::exists(path, ec)) {
+            fs::last_write_time(path, now, ec);
+        }
+    }
+}
+
+std::string ProjectManager::projectTargetName() {
+    // The generated CMakeLists.txt names the executable after the project
+    std::ifstream cmakeLists(projectName + "/CMakeLists.txt");
+    std::string line;
+    while (std::getline(cmakeLists, line)) {
+        size_t pos = line.find("project(");
+        if (pos != std::string::npos && line.find_first_not_of(" \t") == pos) {
+            std::istringstream name(line.substr(pos + 8));
+            std::string target;
+            name >> target;
+            if (!target.empty() && target.back() == ')') {
+                target.pop_back();
+            }
+            return target;
+        }
+    }
+    return fs::absolute(projectName).lexically_normal().parent_path().filename().string();
+}
+
+std::string ProjectManager::cxxCompiler(const std::string& buildDir) {
+    std::string compiler = cacheEntries(buildDir)["CMAKE_CXX_COMPILER"];
+    if (!compiler.empty()) {
+        return compiler;
+    }
+    const char* cxx = getenv("CXX");
+    return cxx ? cxx : "c++";
+}
+
+std::string ProjectManager::cxxStandardFlag() {
+    // set(CMAKE_CXX_STANDARD <n>) in the project's CMakeLists.txt, C++17 (what `init` writes) without it;
+    // a cxx_std_<n> compile feature raises it, as the generated targets of module projects have one
+    std::ifstream cmakeLists(projectName + "/CMakeLists.txt");
+    std::string line;
+    int standard = 0, feature = 0;
+    while (std::getline(cmakeLists, line)) {
+        size_t first = line.find_first_not_of(" \t");
+        if (first == std::string::npos || line[first] == '#') {
+            continue;
+        }
+        if (standard == 0 && line.compare(first, 23, "set(CMAKE_CXX_STANDARD ") == 0) {
+            standard = std::atoi(line.c_str() + first + 23);
+        }
+        size_t pos = line.find("cxx_std_");
+        if (pos != std::string::npos) {
+            feature = std::max(feature, std::atoi(line.c_str() + pos + 8));
+        }
+    }
+    return "-std=c++" + std::to_string(std::max(standard > 0 ? standard : 17, feature));
+}
+
+// Code with comments and string/character literals blanked out, for the declaration heuristics below
+static std::string codeOnly(const std::string& text) {
+    std::string code = text;
+    for (size_t i = 0; i < code.size(); ++i) {
+        if (code.compare(i, 2, "//") == 0) {
+            while (i < code.size() && code[i] != '\n') {
+                code[i++] = ' ';
+            }
+        } else if (code.compare(i, 2, "/*") == 0) {
+            size_t end = code.find("*/", i + 2);
+            end = end == std::string::npos ? code.size() : end + 2;
+            for (; i < end; ++i) {
+                code[i] = code[i] == '\n' ? '\n' : ' ';
+            }
+            --i;
+        } else if (code[i] == '"' || code[i] == '\'') {
+            char quote = code[i];
+            for (++i; i < code.size() && code[i] != quote && code[i] != '\n'; ++i) {
+                if (code[i] == '\\' && i + 1 < code.size()) {
+                    code[i++] = ' ';
+                }
+                code[i] = ' ';
+            }
+        }
+    }
+    // Preprocessor lines (includes in particular) are not uses
+    std::istringstream lines(code);
+    std::string line, result;
+    while (std::getline(lines, line)) {
+        size_t first = line.find_first_not_of(" \t");
+        result += (first != std::string::npos && line[first] == '#') ? "\n" : line + "\n";
+    }
+    return result;
+}
+
+static bool isIdentifierChar(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+// Names of the classes and structs a header defines (scoped enums and declarations excluded)
+static std::set<std::string> definedTypes(const std::string& code) {
+    std::set<std::string> types;
+    for (const std::string keyword : {"class", "struct"}) {
+        for (size_t pos = code.find(keyword); pos != std::string::npos; pos = code.find(keyword, pos + 1)) {
+            if ((pos > 0 && isIdentifierChar(code[pos - 1])) || !std::isspace(static_cast<unsigned char>(code[pos + keyword.size()]))) {
+                continue;
+            }
+            size_t before = code.find_last_not_of(" \t\n", pos == 0 ? 0 : pos - 1);
+            if (before != std::string::npos && before >= 3 && code.compare(before - 3, 4, "enum") == 0) {
+                continue;
+            }
+            size_t nameStart = code.find_first_not_of(" \t\n", pos + keyword.size());
+            size_t nameEnd = nameStart;
+            while (nameEnd < code.size() && isIdentifierChar(code[nameEnd])) {
+                ++nameEnd;
+            }
+            size_t next = code.find_first_not_of(" \t\n", nameEnd);
+            if (next != std::string::npos && code.compare(next, 5, "final") == 0) {
+                next = code.find_first_not_of(" \t\n", next + 5);
+            }
+            if (nameEnd > nameStart && next != std::string::npos && (code[next] == '{' || code[next] == ':') &&
+                code.compare(next, 2, "::") != 0) {
+                types.insert(code.substr(nameStart, nameEnd - nameStart));
+            }
+        }
+    }
+    return types;
+}
+
+// True when code names at least one of types and only ever as a pointer, a reference or in a
+// forward declaration, i.e. a declaration would do instead of the definition
+static bool onlyNeedsDeclarations(const std::string& code, const std::set<std::string>& types, std::string& used) {
+    bool any = false;
+    for (const auto& type : types) {
+        for (size_t pos = code.find(type); pos != std::string::npos; pos = code.find(type, pos + type.size())) {
+            size_t end = pos + type.size();
+            if ((pos > 0 && isIdentifierChar(code[pos - 1])) || (end < code.size() && isIdentifierChar(code[end]))) {
+                continue;
+            }
+            size_t next = code.find_first_not_of(" \t\n", end);
+            size_t prev = pos == 0 ? std::string::npos : code.find_last_not_of(" \t\n", pos - 1);
+            std::string previousWord;
+            for (size_t i = prev; i != std::string::npos && isIdentifierChar(code[i]); --i) {
+                previousWord.insert(previousWord.begin(), code[i]);
+                if (i == 0) {
+                    break;
+                }
+            }
+            bool declaration = (previousWord == "class" || previousWord == "struct") && next != std::string::npos &&
+                               code[next] == ';';
+            bool indirect = next != std::string::npos && (code[next] == '*' || code[next] == '&');
+            if (!declaration && !indirect) {
+                return false;
+            }
+            if (!declaration && used.find(type) == std::string::npos) {
+                used += (used.empty() ? "" : ", ") + type;
+            }
+            any = any || !declaration;
+        }
+    }
+    return any;
+}
+
+std::map<std::string, double> ProjectManager::translationUnitTimes(const IncludeGraph& graph, bool measure,
+                                                                    std::string& origin) {
+    std::map<std::string, double> seconds;
+    std::string buildDir = projectName + "/build";
+    if (!measure) {
+        // CMake's Ninja layout: CMakeFiles/<target>.dir/<source>.o
+        for (const auto& [output, times] : readNinjaLog(buildDir, fs::file_time_type::min())) {
+            size_t dir = output.find(".dir/");
+            std::string extension = fs::path(output).extension().string();
+            if (dir == std::string::npos || (extension != ".o" && extension != ".obj")) {
+                continue;
+            }
+            std::string source = output.substr(dir + 5, output.size() - dir - 5 - extension.size());
+            if (graph.contains(source)) {
+                seconds[source] = (times.second - times.first) / 1000.0;
+            }
+        }
+        if (!seconds.empty()) {
+            origin = "compile times from the last Ninja build";
+            return seconds;
+        }
+    }
+
+    // No Ninja log (or --measure): time a syntax-only compile of every translation unit, with the flags
+    // of its compile_commands.json entry (standard, definitions, module maps) when the project was built
+    std::map<std::string, ProcessSpec> configured;
+    JsonValue commands;
+    if (JsonValue::parseFile(buildDir + "/compile_commands.json", commands) && commands.isArray()) {
+        fs::path root = fs::absolute(projectName).lexically_normal();
+        for (const auto& entry : commands.items()) {
+            ProcessSpec spec;
+            spec.workingDirectory = entry["directory"].asString();
+            std::vector<std::string> argv;
+            if (entry.contains("arguments")) {
+                for (const auto& arg : entry["arguments"].items()) {
+                    argv.push_back(arg.asString());
+                }
+            } else {
+                argv = splitCommand(entry["command"].asString());
+            }
+            // No object and no dependency file: the build's own outputs stay as they are
+            for (size_t i = 0; i < argv.size(); ++i) {
+                if (argv[i] == "-o" || argv[i] == "-MF" || argv[i] == "-MT" || argv[i] == "-MQ") {
+                    ++i;
+                } else if (argv[i] == "-c") {
+                    spec.argv.push_back("-fsyntax-only");
+                } else if (argv[i] != "-MD" && argv[i] != "-MMD") {
+                    spec.argv.push_back(argv[i]);
+                }
+            }
+            fs::path file = fs::path(spec.workingDirectory) / entry["file"].asString();
+            configured[file.lexically_normal().lexically_relative(root).string()] = spec;
+        }
+    }
+
+    std::vector<std::string> units;
+    std::vector<ProcessSpec> specs;
+    std::string compiler = cxxCompiler(buildDir);
+    std::string standard = cxxStandardFlag();
+    for (const auto& file : graph.files()) {
+        if (IncludeGraph::isSource(file) && file.rfind("src/", 0) == 0) {
+            auto known = configured.find(file);
+            ProcessSpec spec = known != configured.end() ? known->second : ProcessSpec();
+            if (spec.argv.empty()) {
+                spec.argv = {compiler, standard, "-fsyntax-only", "-I" + projectName + "/include",
+                             projectName + "/" + file};
+            }
+            spec.stdoutMode = ProcessOutput::Discard;
+            spec.stderrMode = ProcessOutput::Discard;
+            specs.push_back(spec);
+            units.push_back(file);
+        }
+    }
+    auto results = Process::runAll(specs, std::max(1u, std::thread::hardware_concurrency()));
+    for (size_t i = 0; i < units.size(); ++i) {
+        seconds[units[i]] = results[i].seconds;
+    }
+    origin = "measured syntax-only compile times";
+    return seconds;
+}
+
+bool ProjectManager::analyzeRebuildCost(size_t top, bool measure) {
+    IncludeGraph graph = includeGraph();
+    std::string origin;
+    auto unitSeconds = translationUnitTimes(graph, measure, origin);
+    if (unitSeconds.empty()) {
+        std::cerr << "No translation unit timings; build with Ninja first or pass --measure." << std::endl;
+        return false;
+    }
+
+    // Seconds of recompilation one edit of header costs, and how many units that is
+    auto cost = [&](const std::string& header, const std::pair<std::string, std::string>& without) {
+        std::pair<double, size_t> total{0, 0};
+        for (const auto& file : graph.includers(header, without)) {
+            auto it = unitSeconds.find(file);
+            if (it != unitSeconds.end()) {
+                total.first += it->second;
+                ++total.second;
+            }
+        }
+        return total;
+    };
+
+    std::vector<std::tuple<double, size_t, std::string>> ranking;
+    for (const auto& file : graph.files()) {
+        if (!IncludeGraph::isSource(file)) {
+            auto [seconds, units] = cost(file, {});
+            if (units > 0) {
+                ranking.push_back({seconds, units, file});
+            }
+        }
+    }
+    std::sort(ranking.begin(), ranking.end(), [](const auto& a, const auto& b) {
+        return std::get<0>(a) != std::get<0>(b) ? std::get<0>(a) > std::get<0>(b) : std::get<2>(a) < std::get<2>(b);
+    });
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Rebuild cost per header edit (" << origin << "):" << std::endl;
+    std::cout << "  seconds    TUs  header" << std::endl;
+    for (size_t i = 0; i < std::min(top, ranking.size()); ++i) {
+        std::cout << std::setw(9) << std::get<0>(ranking[i]) << std::setw(7) << std::get<1>(ranking[i]) << "  "
+                  << std::get<2>(ranking[i]) << std::endl;
+    }
+
+    // A header that only needs pointers or references to another header's types can forward declare
+    // them; the saving is what that header's edits stop costing the translation units reached through here
+    std::map<std::string, std::string> code;
+    auto codeOf = [&](const std::string& file) -> const std::string& {
+        auto it = code.find(file);
+        if (it == code.end()) {
+            std::ifstream in(projectName + "/" + file, std::ios::binary);
+            std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            it = code.emplace(file, codeOnly(text)).first;
+        }
+        return it->second;
+    };
+    std::vector<std::tuple<double, std::string>> candidates;
+    for (const auto& includer : graph.files()) {
+        if (IncludeGraph::isSource(includer)) {
+            continue;
+        }
+        for (const auto& header : graph.includes(includer)) {
+            std::set<std::string> types = definedTypes(codeOf(header));
+            std::string used;
+            if (types.empty() || !onlyNeedsDeclarations(codeOf(includer), types, used)) {
+                continue;
+            }
+            auto before = cost(header, {});
+            auto after = cost(header, {includer, header});
+            double saved = before.first - after.first;
+            if (saved <= 0) {
+                continue;
+            }
+            std::ostringstream line;
+            line << std::fixed << std::setprecision(2) << includer << ": forward declare " << used << " instead of including "
+                 << header << "; saves ~" << saved << "s (" << before.second - after.second << " TUs) per edit of "
+                 << header;
+            candidates.push_back({saved, line.str()});
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) {
+        return std::get<0>(a) != std::get<0>(b) ? std::get<0>(a) > std::get<0>(b) : std::get<1>(a) < std::get<1>(b);
+    });
+
+    std::cout << "Forward-declaration candidates:" << std::endl;
+    if (candidates.empty()) {
+        std::cout << "  none found" << std::endl;
+    }
+    for (size_t i = 0; i < std::min(top, candidates.size()); ++i) {
+        std::cout << "  " << std::get<1>(candidates[i]) << std::endl;
+    }
+    // Sources that use the full types must then include the header themselves
+    if (!candidates.empty()) {
+        std::cout << "Savings are upper bounds: files that need the full definition must include it directly." << std::endl;
+    }
+    return true;
+}
+
+bool ProjectManager::analyzePrecompiledHeader(unsigned threshold) {
+    IncludeGraph graph = includeGraph();
+    std::vector<std::string> files;
+    for (const auto& file : graph.files()) {
+        if ((file.rfind("src/", 0) == 0 || file.rfind("include/", 0) == 0) && file != "include/pch.h") {
+            files.push_back(file);
+        }
+    }
+
+    // Count each header once per including file. Includes that resolve inside the project are
+    // project headers and would invalidate the PCH on every edit, so skip them.
+    std::map<std::string, unsigned> usage;
+    auto exists = [&](const std::string& path) { return graph.contains(path); };
+    for (const auto& file : files) {
+        std::set<std::string> seen;
+        for (const auto& directive : graph.directives(file)) {
+            if (!IncludeGraph::resolve(file, directive, exists).empty()) {
+                continue;
+            }
+            std::string spelled = directive.angled ? "<" + directive.header + ">" : "\"" + directive.header + "\"";
+            if (seen.insert(spelled).second) {
+                ++usage[spelled];
+            }
+        }
+    }
+
+    if (threshold == 0) {
+        threshold = std::max<unsigned>(2, static_cast<unsigned>(files.size() / 4));
+    }
+    std::vector<std::pair<std::string, unsigned>> selected;
+    for (const auto& [header, count] : usage) {
+        if (count >= threshold) {
+            selected.push_back({header, count});
+        }
+    }
+    std::sort(selected.begin(), selected.end(), [](const auto& a, const auto& b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    });
+
+    std::cout << "Scanned " << files.size() << " files, " << usage.size() << " external headers, threshold "
+              << threshold << " includers." << std::endl;
+    if (selected.empty()) {
+        std::cout << "No header crosses the threshold; pch.h not generated." << std::endl;
+        return true;
+    }
+
+    // Measure what each header costs to parse with a sample -fsyntax-only compile, minus an empty TU
+    std::string probeDir = projectName + "/build/pch";
+    createDirectory(probeDir);
+    std::string compiler = cxxCompiler(projectName + "/build");
+    std::string standard = cxxStandardFlag();
+    auto timeProbe = [&](const std::string& content, size_t* headerCount) {
+        createFile(probeDir + "/probe.cpp", content);
+        ProcessSpec spec;
+        spec.argv = {compiler, standard, "-fsyntax-only", "-H", "-I" + projectName + "/include",
+                     probeDir + "/probe.cpp"};
+        spec.stderrMode = ProcessOutput::Capture;
+        ProcessResult result = Process::run(spec);
+        if (headerCount) {
+            // -H prints one dotted line per header opened, nested headers included
+            std::istringstream trace(result.err);
+            std::string line;
+            *headerCount = 0;
+            while (std::getline(trace, line)) {
+                *headerCount += (!line.empty() && line[0] == '.');
+            }
+        }
+        return result.exitCode == 0 ? result.seconds : -1.0;
+    };
+    double baseline = std::max(0.0, timeProbe("\n", nullptr));
+
+    std::string pchContent = R"(
+#ifndef CPP_MANAGER_PCH_H
+#define CPP_MANAGER_PCH_H
+
+// Generated by `cpp-manager pch analyze`. Re-run it to refresh.
+)";
+    double totalSaved = 0;
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Precompiled headers:" << std::endl;
+    for (const auto& [header, count] : selected) {
+        pchContent += "#include " + header + "\n";
+
+        size_t headerCount = 0;
+        double seconds = timeProbe("#include " + header + "\n", &headerCount);
+        std::cout << "  " << header << "  included by " << count << " files";
+        if (seconds < 0) {
+            std::cout << ", parse time unknown (sample compile failed)" << std::endl;
+            continue;
+        }
+        double parseMs = std::max(0.0, seconds - baseline) * 1000.0;
+        // The PCH itself still parses every header once
+        double savedMs = parseMs * (count - 1);
+        totalSaved += savedMs;
+        std::cout << ", " << headerCount << " headers, " << parseMs << " ms each, ~" << savedMs << " ms saved"
+                  << std::endl;
+    }
+    pchContent += R"(
+#endif // CPP_MANAGER_PCH_H
+)";
+
+    createFile(projectName + "/include/pch.h", pchContent);
+    wirePrecompiledHeader();
+    // Headers share dependencies (e.g. <string> inside <iostream>), so the sum is an upper bound
+    std::cout << "Estimated parse time saved per full build: up to " << totalSaved / 1000.0 << "s" << std::endl;
+    std::cout << "Generated " << projectName << "/include/pch.h" << std::endl;
+    return true;
+}
+
+void ProjectManager::wirePrecompiledHeader() {
+    std::string cmakePath = projectName + "/CMakeLists.txt";
+    std::ifstream in(cmakePath);
+    std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+    if (content.find("target_precompile_headers(") != std::string::npos) {
+        return;
+    }
+
+    content += R"(
+# Precompiled header generated by `cpp-manager pch analyze`
+if(EXISTS "${CMAKE_SOURCE_DIR}/include/pch.h" AND NOT CMAKE_VERSION VERSION_LESS 3.16)
+    foreach(target )" + projectTargetName() + R"( ${CPP_MANAGER_MODULES})
+        target_precompile_headers(${target} PRIVATE "${CMAKE_SOURCE_DIR}/include/pch.h")
+    endforeach()
+endif()
+)";
+    createFile(cmakePath, content);
+}
+
+void ProjectManager::wireDependencies(const std::string& buildDir) {
+    std::ifstream conanfile(projectName + "/conanfile.txt");
+    if (!conanfile) {
+        return;
+    }
+    std::string requirements((std::istreambuf_iterator<char>(conanfile)), std::istreambuf_iterator<char>());
+    std::string cmakePath = projectName + "/CMakeLists.txt";
+    std::ifstream in(cmakePath);
+    std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+
+    std::string target = projectTargetName();
+    std::string block = dependencyBlock(target, cmakeDepsPackages(buildDir, conanPackageNames(requirements)));
+    size_t begin = content.find(kDependenciesBegin);
+    size_t end = content.find(kDependenciesEnd);
+    if (begin != std::string::npos && end != std::string::npos && end > begin) {
+        end = content.find('\n', end);
+        content.replace(begin, end == std::string::npos ? std::string::npos : end + 1 - begin, block);
+    } else {
+        // Projects from before Conan 2 support link ${CONAN_LIBS}, which is always empty there
+        bool legacyFound = false;
+        for (const std::string& legacy :
+             {"# Link Conan dependencies\ntarget_link_libraries(" + target + " PRIVATE ${CONAN_LIBS})\n",
+              std::string("# Conan dependencies are installed from conan.lock by `cpp-manager build` before CMake "
+                          "runs\nif(EXISTS \"${CMAKE_BINARY_DIR}/conanbuildinfo.cmake\")\n    "
+                          "include(${CMAKE_BINARY_DIR}/conanbuildinfo.cmake)\n    conan_basic_setup()\nendif()\n\n")}) {
+            size_t found = content.find(legacy);
+            if (found != std::string::npos) {
+                content.erase(found, legacy.size());
+                legacyFound = true;
+            }
+        }
+        // Hand-written CMakeLists.txt files link their packages themselves
+        if (!legacyFound && !TargetGraph::hasBlock(content)) {
+            return;
+        }
+        content += (content.empty() || content.back() == '\n' ? "\n" : "\n\n") + block;
+    }
+    createFile(cmakePath, content);
+}
+
+void ProjectManager::wireBenchmarks() {
+    std::string cmakePath = projectName + "/CMakeLists.txt";
+    std::ifstream in(cmakePath);
+    std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+    if (content.find("benchmark::benchmark_main") != std::string::npos) {
+        return;
+    }
+
+    std::string target = projectTargetName();
+    content += R"(
+# Benchmarks generated by `cpp-manager create bench`, run by `cpp-manager bench`
+find_package(benchmark QUIET)
+if(benchmark_FOUND)
+    file(GLOB CPP_MANAGER_BENCHMARKS CONFIGURE_DEPENDS "${CMAKE_SOURCE_DIR}/bench/*.cpp")
+    foreach(source ${CPP_MANAGER_BENCHMARKS})
+        get_filename_component(name ${source} NAME_WE)
+        add_executable()" + target + R"(_bench_${name} ${source})
+        target_link_libraries()" + target + R"(_bench_${name} PRIVATE ${CPP_MANAGER_MODULES} benchmark::benchmark_main)
+    endforeach()
+else()
+    message(STATUS "Google Benchmark not found, bench/ is not built")
+endif()
+)";
+    createFile(cmakePath, content);
+}
+
+std::string ProjectManager::compilerCacheProgram() {
+    // Same preference order as the generated CMakeLists.txt
+    for (const char* program : {"ccache", "sccache"}) {
+        if (commandExists(program)) {
+            return program;
+        }
+    }
+    return "";
+}
+
+std::pair<long, long> ProjectManager::compilerCacheCounters(const std::string& program) {
+    long hits = 0, misses = 0;
+    if (program == "ccache") {
+        // Machine readable "key<TAB>value" lines
+        std::istringstream stats(captureCommandOutput({"ccache", "--print-stats"}));
+        std::string key;
+        long value = 0;
+        while (stats >> key >> value) {
+            if (key == "direct_cache_hit" || key == "preprocessed_cache_hit") {
+                hits += value;
+            } else if (key == "cache_miss") {
+                misses += value;
+            }
+        }
+    } else {
+        std::istringstream stats(captureCommandOutput({"sccache", "--show-stats"}));
+        std::string line;
+        while (std::getline(stats, line)) {
+            std::istringstream fields(line);
+            std::string first, second;
+            long value = 0;
+            if (fields >> first >> second >> value && first == "Cache") {
+                if (second == "hits") {
+                    hits = value;
+                } else if (second == "misses") {
+                    misses = value;
+                }
+            }
+        }
+    }
+    return {hits, misses};
+}
+
+bool ProjectManager::cacheCommand(const std::string& subCommand, const std::string& argument) {
+    std::string program = compilerCacheProgram();
+    if (program.empty()) {
+        std::cerr << "No compiler cache found. Install ccache or sccache." << std::endl;
+        return false;
+    }
+
+    if (subCommand == "stats") {
+        return executeCommand({program, "--show-stats"}) == 0;
+    }
+
+    if (subCommand == "clear") {
+        if (program == "ccache") {
+            return executeCommand({"ccache", "--clear"}) == 0;
+        }
+        // sccache has no clear command; stop the server and drop its local cache directory
+        ProcessSpec stopServer;
+        stopServer.argv = {"sccache", "--stop-server"};
+        stopServer.stdoutMode = ProcessOutput::Discard;
+        stopServer.stderrMode = ProcessOutput::Discard;
+        Process::run(stopServer);
+        const char* dir = getenv("SCCACHE_DIR");
+        const char* home = getenv("HOME");
+        std::string cacheDir = dir ? dir : (home ? std::string(home) + "/.cache/sccache" : "");
+        if (!cacheDir.empty()) {
+            std::error_code ec;
+            fs::remove_all(cacheDir, ec);
+        }
+        std::cout << "Compiler cache cleared." << std::endl;
+        return true;
+    }
+
+    if (subCommand == "limit" && !argument.empty()) {
+        if (program == "ccache") {
+            return executeCommand({"ccache", "--max-size", argument}) == 0;
+        }
+        // sccache reads its size limit from the environment when the server starts
+        std::cout << "sccache reads its limit at server start. Run:\n"
+                  << "  sccache --stop-server && export SCCACHE_CACHE_SIZE=" << argument << std::endl;
+        return true;
+    }
+
+    std::cerr << "Usage: cpp-manager cache stats|clear|limit <size>" << std::endl;
+    return false;
+}
+
+void ProjectManager::reportNinjaPhases(const std::string& buildDir, fs::file_time_type buildStart) {
+    auto latest = readNinjaLog(buildDir, buildStart);
+    long compileBegin = -1, compileEnd = 0, linkBegin = -1, linkEnd = 0;
+    int objects = 0, links = 0;
+    for (const auto& [output, span] : latest) {
+        std::string extension = fs::path(output).extension().string();
+        bool isObject = extension == ".o" || extension == ".obj";
+        long& begin = isObject ? compileBegin : linkBegin;
+        long& finish = isObject ? compileEnd : linkEnd;
+        begin = (begin < 0) ? span.first : std::min(begin, span.first);
+        finish = std::max(finish, span.second);
+        ++(isObject ? objects : links);
+    }
+
+    std::cout << "  compile: " << (objects ? (compileEnd - compileBegin) / 1000.0 : 0.0) << "s ("
+              << objects << " objects)" << std::endl;
+    std::cout << "  link: " << (links ? (linkEnd - linkBegin) / 1000.0 : 0.0) << "s ("
+              << links << " targets)" << std::endl;
+}
+
+int ProjectManager::runTests(const TestOptions& options) {
+    std::string buildDir = projectName + "/" + profileBuildDir(options.profile, options.buildDir);
+    if ((!options.profile.empty() || !options.buildDir.empty()) && !fs::is_directory(buildDir)) {
+        std::cerr << "No build tree in " << buildDir << ". Build it first with `cpp-manager build"
+                  << (options.profile.empty() ? "" : " --profile " + options.profile) << " --build-dir "
+                  << profileBuildDir(options.profile, options.buildDir) << "`." << std::endl;
+        return 1;
+    }
+    std::vector<std::string> names = options.names;
+    if (options.changedOnly) {
+        if (!selectAffectedTests(buildDir, options.changedSince, names)) {
+            return 1;
+        }
+        if (names.empty()) {
+            std::cout << "No tests affected by changes since " << options.changedSince << "." << std::endl;
+            return 0;
+        }
+    }
+
+    std::vector<TestCase> tests;
+    for (auto& test : listTests(buildDir)) {
+        if (names.empty() || std::find(names.begin(), names.end(), test.name) != names.end()) {
+            tests.push_back(std::move(test));
+        }
+    }
+    if (tests.empty()) {
+        std::cout << "No tests found in " << buildDir << "." << std::endl;
+        return 0;
+    }
+
+    Trace::Phase phase("run");
+    TestRunner runner(buildDir, options.jobs);
+    int result = runner.run(tests, options.junitPath.empty() ? buildDir + "/test-results.xml" : options.junitPath);
+    if (result == 0) {
+        std::cout << "Tests executed successfully!" << std::endl;
+    } else {
+        std::cerr << "Some tests failed." << std::endl;
+    }
+    return result;
+}
+
+int ProjectManager::runBenchmarks(const BenchOptions& options) {
+    BuildOptions buildOptions;
+    buildOptions.profile = options.profile;
+    buildOptions.buildDir = profileBuildDir(options.profile, options.buildDir);
+    if (!buildProject(buildOptions)) {
+        return 1;
+    }
+    std::string buildDir = projectName + "/" + buildOptions.buildDir;
+    std::string buildType = cacheEntries(buildDir)["CMAKE_BUILD_TYPE"];
+    if (buildType != "Release" && buildType != "RelWithDebInfo") {
+        std::cerr << "Warning: benchmarking " << (buildType.empty() ? "an unoptimized" : "a " + buildType)
+                  << " build. Configure with -DCMAKE_BUILD_TYPE=Release for meaningful numbers." << std::endl;
+    }
+
+    auto executables = benchmarkExecutables(buildDir);
+    if (executables.empty()) {
+        std::cout << "No benchmarks found in " << buildDir << ". Create one with `cpp-manager create bench <name>`;"
+                  << " Google Benchmark has to be installed or required in conanfile.txt." << std::endl;
+        return 0;
+    }
+
+    Trace::Phase phase("run");
+    BenchRunner runner(options.cpu);
+    std::cout << "Running " << executables.size() << " benchmark executables, " << options.repetitions
+              << " repetitions each, pinned to CPU " << runner.pinnedCpu() << std::endl;
+    std::vector<std::pair<std::string, std::vector<double>>> samples;
+    for (const auto& executable : executables) {
+        if (!runner.run(executable, options.filter, options.repetitions, samples)) {
+            return 1;
+        }
+    }
+    std::map<std::string, BenchSummary> summaries;
+    for (const auto& [name, values] : samples) {
+        summaries[name] = BenchRunner::summarize(values);
+    }
+
+    // Results are kept per commit in the project, so they survive a clean build directory
+    std::string resultsDir = projectName + kBenchResults;
+    std::string commit = commitId();
+    std::string baselineCommit;
+    if (!options.baseline.empty()) {
+        baselineCommit = captureCommandOutput({"git", "rev-parse", "--verify", options.baseline + "^{commit}"}, projectName);
+        baselineCommit.erase(baselineCommit.find_last_not_of("\n") + 1);
+        if (baselineCommit.empty()) {
+            std::cerr << "Unknown baseline: " << options.baseline << std::endl;
+            return 1;
+        }
+    } else {
+        std::ifstream baselineFile(resultsDir + "/baseline");
+        std::getline(baselineFile, baselineCommit);
+    }
+    std::map<std::string, BenchSummary> baseline;
+    bool compare = !baselineCommit.empty() && BenchRunner::load(resultsDir + "/" + baselineCommit + ".json", baseline);
+    if (!options.baseline.empty() && !compare) {
+        std::cerr << "No stored benchmark results for " << options.baseline << " (" << baselineCommit
+                  << "). Check it out and run `cpp-manager bench` first." << std::endl;
+        return 1;
+    }
+
+    size_t regressions = 0;
+    std::cout << std::left << std::setw(40) << "Benchmark" << std::right << std::setw(12) << "median" << std::setw(12)
+              << "stddev" << std::setw(12) << "kept" << (compare ? "  vs " + baselineCommit.substr(0, 12) : "")
+              << std::endl;
+    for (const auto& [name, values] : samples) {
+        const BenchSummary& summary = summaries[name];
+        // Repetitions kept after outlier rejection, of all that ran
+        std::string kept = std::to_string(summary.samples) + "/" + std::to_string(summary.samples + summary.rejected);
+        std::cout << std::left << std::setw(40) << name << std::right << std::setw(12)
+                  << formatNanoseconds(summary.median) << std::setw(12) << formatNanoseconds(summary.stddev)
+                  << std::setw(12) << kept;
+        auto before = baseline.find(name);
+        if (compare && before != baseline.end() && before->second.median > 0) {
+            double change = (summary.median / before->second.median - 1) * 100;
+            std::cout << "  " << std::showpos << std::fixed << std::setprecision(1) << change << "%" << std::noshowpos;
+            if (change > options.threshold) {
+                std::cout << "  REGRESSED";
+                ++regressions;
+            } else if (change < -options.threshold) {
+                std::cout << "  improved";
+            }
+        } else if (compare) {
+            std::cout << "  new";
+        }
+        std::cout << std::endl;
+    }
+
+    std::string resultsPath = resultsDir + "/" + commit + ".json";
+    if (!BenchRunner::save(resultsPath, commit, summaries)) {
+        return 1;
+    }
+    std::cout << "Results saved to " << resultsPath << std::endl;
+    if (options.saveBaseline) {
+        createFile(resultsDir + "/baseline", commit + "\n");
+        std::cout << "Baseline set to " << commit << std::endl;
+    }
+
+    if (regressions > 0) {
+        std::cerr << regressions << " benchmarks regressed by more than " << options.threshold << "% against "
+                  << baselineCommit << "." << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+std::vector<std::string> ProjectManager::benchmarkExecutables(const std::string& buildDir) {
+    // The generated CMakeLists.txt builds bench/<name>.cpp as <project>_bench_<name>
+    std::string prefix = projectTargetName() + "_bench_";
+    std::vector<std::string> executables;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(buildDir, ec)) {
+        if (entry.path().filename().string().rfind(prefix, 0) == 0 && entry.is_regular_file(ec) &&
+            access(entry.path().c_str(), X_OK) == 0) {
+            executables.push_back(entry.path().string());
+        }
+    }
+    std::sort(executables.begin(), executables.end());
+    return executables;
+}
+
+std::string ProjectManager::commitId() {
+    std::string commit = captureCommandOutput({"git", "rev-parse", "HEAD"}, projectName);
+    commit.erase(commit.find_last_not_of("\n") + 1);
+    if (commit.empty()) {
+        return "working-tree";
+    }
+    // Uncommitted changes to tracked files must not overwrite the results of the commit itself
+    if (!captureCommandOutput({"git", "status", "--porcelain", "--untracked-files=no"}, projectName).empty()) {
+        commit += "-dirty";
+    }
+    return commit;
+}
+
+std::vector<TestCase> ProjectManager::listTests(const std::string& buildDir) {
+    // CMake 3.14+ describes every test with its properties; the ones a run depends on are honored
+    JsonValue listing;
+    if (JsonValue::parse(captureCommandOutput({"ctest", "--show-only=json-v1"}, buildDir), listing) &&
+        listing.contains("tests")) {
+        std::vector<TestCase> tests;
+        for (const auto& test : listing["tests"].items()) {
+            TestCase current;
+            current.name = test["name"].asString();
+            for (const auto& arg : test["command"].items()) {
+                current.command.push_back(arg.asString());
+            }
+            bool disabled = false;
+            for (const auto& property : test["properties"].items()) {
+                std::string name = property["name"].asString();
+                const JsonValue& value = property["value"];
+                if (name == "WORKING_DIRECTORY") {
+                    current.workingDirectory = value.asString();
+                } else if (name == "WILL_FAIL") {
+                    current.willFail = value.asBool();
+                } else if (name == "TIMEOUT") {
+                    current.timeoutSeconds = value.asNumber();
+                } else if (name == "DISABLED") {
+                    disabled = value.asBool();
+                } else if (name == "ENVIRONMENT") {
+                    for (const auto& variable : value.items()) {
+                        std::string entry = variable.asString();
+                        size_t equals = entry.find('=');
+                        if (equals != std::string::npos) {
+                            current.environment[entry.substr(0, equals)] = entry.substr(equals + 1);
+                        }
+                    }
+                }
+            }
+            if (!disabled && !current.command.empty()) {
+                tests.push_back(current);
+            }
+        }
+        return tests;
+    }
+
+    // Older CTest: `ctest -N -V` prints "<n>: Test command: <exe> "<arg>"...", "<n>: Working Directory: <dir>"
+    // and then "  Test #<n>: <name>" for every test
+    std::vector<TestCase> tests;
+    std::istringstream output(captureCommandOutput({"ctest", "-N", "-V"}, buildDir));
+    std::string line;
+    TestCase current;
+    while (std::getline(output, line)) {
+        size_t pos;
+        if ((pos = line.find(": Test command: ")) != std::string::npos) {
+            current.command.clear();
+            std::string command = line.substr(pos + 16);
+            std::string arg;
+            bool quoted = false;
+            for (char c : command) {
+                if (c == '"') {
+                    quoted = !quoted;
+                } else if (c == ' ' && !quoted) {
+                    if (!arg.empty()) {
+                        current.command.push_back(arg);
+                    }
+                    arg.clear();
+                } else {
+                    arg += c;
+                }
+            }
+            if (!arg.empty()) {
+                current.command.push_back(arg);
+            }
+        } else if ((pos = line.find(": Working Directory: ")) != std::string::npos) {
+            current.workingDirectory = line.substr(pos + 21);
+        } else if ((pos = line.find("  Test #")) == 0 && (pos = line.find(": ")) != std::string::npos) {
+            current.name = line.substr(pos + 2);
+            tests.push_back(current);
+            current = TestCase();
+        }
+    }
+    return tests;
+}
+
+std::vector<std::string> ProjectManager::changedFiles(const std::string& ref) {
+    std::string root = captureCommandOutput({"git", "rev-parse", "--show-toplevel"}, projectName);
+    root.erase(root.find_last_not_of("\n") + 1);
+    if (root.empty()) {
+        return {};
+    }
+
+    // Committed, staged and unstaged changes since ref, plus files git does not know yet
+    std::istringstream output(captureCommandOutput({"git", "diff", "--name-only", ref, "--"}, projectName) +
+                              captureCommandOutput({"git", "ls-files", "--others", "--exclude-standard", "--full-name"},
+                                                   projectName));
+    std::vector<std::string> files;
+    std::string line;
+    while (std::getline(output, line)) {
+        if (!line.empty()) {
+            files.push_back((fs::path(root) / line).lexically_normal().string());
+        }
+    }
+    return files;
+}
+
+std::map<std::string, std::set<std::string>> ProjectManager::targetSourceDependencies(const std::string& buildDir) {
+    // Objects live in "<dir>/CMakeFiles/<target>.dir/...", so the target name comes from the path
+    auto targetOf = [](const std::string& object) {
+        for (const auto& part : fs::path(object)) {
+            std::string name = part.string();
+            if (name.size() > 4 && name.compare(name.size() - 4, 4, ".dir") == 0) {
+                return name.substr(0, name.size() - 4);
+            }
+        }
+        return std::string();
+    };
+    auto absolute = [&](const std::string& path) {
+        fs::path dep(path);
+        return (dep.is_absolute() ? dep : fs::absolute(fs::path(buildDir) / dep)).lexically_normal().string();
+    };
+
+    std::map<std::string, std::set<std::string>> deps;
+    if (cachedGenerator(buildDir) == "Ninja") {
+        // Ninja folds depfiles into .ninja_deps: "<object>: #deps N, ..." followed by indented paths
+        std::istringstream output(captureCommandOutput({"ninja", "-C", buildDir, "-t", "deps"}));
+        std::string line, target;
+        while (std::getline(output, line)) {
+            if (line.empty()) {
+                continue;
+            }
+            if (line[0] != ' ') {
+                target = targetOf(line.substr(0, line.find(':')));
+            } else if (!target.empty()) {
+                deps[target].insert(absolute(line.substr(line.find_first_not_of(' '))));
+            }
+        }
+        return deps;
+    }
+
+    // Make: the compiler's -MD depfiles next to each object
+    std::error_code ec;
+    for (auto it = fs::recursive_directory_iterator(buildDir, ec);
+         !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        if (!it->is_regular_file() || it->path().extension() != ".d") {
+            continue;
+        }
+        std::string target = targetOf(fs::relative(it->path(), buildDir).string());
+        if (target.empty()) {
+            continue;
+        }
+        std::ifstream depfile(it->path());
+        std::string content((std::istreambuf_iterator<char>(depfile)), std::istreambuf_iterator<char>());
+        // "<object>: <dep> <dep> \<newline> <dep>...", spaces inside paths escaped as "\ "
+        std::string token;
+        for (size_t i = 0; i <= content.size(); ++i) {
+            char c = i < content.size() ? content[i] : ' ';
+            if (c == '\\' && i + 1 < content.size() && (content[i + 1] == '\n' || content[i + 1] == ' ')) {
+                if (content[++i] == ' ') {
+                    token += ' ';
+                    continue;
+                }
+                c = ' ';
+            }
+            if (c != ' ' && c != '\n' && c != '\t') {
+                token += c;
+                continue;
+            }
+            if (!token.empty() && token.back() != ':') {
+                deps[target].insert(absolute(token));
+            }
+            token.clear();
+        }
+    }
+    return deps;
+}
+
+std::map<std::string, std::set<std::string>> ProjectManager::targetLinkDependencies(const std::string& buildDir) {
+    // Libraries on a link line are "lib<target>.a" / "lib<target>.so"
+    auto libraryTarget = [](const std::string& token) {
+        fs::path path(token);
+        std::string name = path.stem().string();
+        if ((path.extension() == ".a" || path.extension() == ".so") && name.rfind("lib", 0) == 0) {
+            return name.substr(3);
+        }
+        return std::string();
+    };
+
+    std::map<std::string, std::set<std::string>> links;
+    std::error_code ec;
+    if (cachedGenerator(buildDir) == "Ninja") {
+        std::ifstream buildNinja(buildDir + "/build.ninja");
+        std::string line;
+        while (std::getline(buildNinja, line)) {
+            if (line.rfind("build ", 0) != 0 || line.find("_LINKER__") == std::string::npos) {
+                continue;
+            }
+            std::istringstream tokens(line.substr(6));
+            std::string output, token;
+            tokens >> output;
+            std::string target = fs::path(output).stem().string();
+            if (target.rfind("lib", 0) == 0 && !libraryTarget(output).empty()) {
+                target = libraryTarget(output);
+            }
+            while (tokens >> token) {
+                std::string library = libraryTarget(token);
+                if (!library.empty() && library != target) {
+                    links[target].insert(library);
+                }
+            }
+        }
+        return links;
+    }
+
+    for (auto it = fs::recursive_directory_iterator(buildDir, ec);
+         !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        if (it->path().filename() != "link.txt") {
+            continue;
+        }
+        std::string targetDir = it->path().parent_path().filename().string();
+        std::string target = targetDir.substr(0, targetDir.size() - 4);
+        std::ifstream linkTxt(it->path());
+        std::string token;
+        while (linkTxt >> token) {
+            std::string library = libraryTarget(token);
+            if (!library.empty() && library != target) {
+                links[target].insert(library);
+            }
+        }
+    }
+    return links;
+}
+
+bool ProjectManager::selectAffectedTests(const std::string& buildDir, const std::string& ref,
+                                         std::vector<std::string>& names) {
+    auto changed = changedFiles(ref);
+    auto tests = listTests(buildDir);
+    auto allTests = [&]() {
+        for (const auto& test : tests) {
+            names.push_back(test.name);
+        }
+        return true;
+    };
 
-[generators]
-CMakeToolchain
-)";
-        createFile(projectName + "/conanfile.txt", conanfileContent);
+    if (captureCommandOutput({"git", "rev-parse", "--git-dir"}, projectName).empty()) {
+        std::cerr << "--changed needs a git repository." << std::endl;
+        return false;
+    }
+    if (changed.empty()) {
+        return true;
     }
 
-    executeCommand("cd " + projectName + " && git init");
+    // Build system inputs can change every target
+    for (const auto& file : changed) {
+        std::string name = fs::path(file).filename().string();
+        if (name == "CMakeLists.txt" || name == "conanfile.txt" || fs::path(file).extension() == ".cmake") {
+            std::cout << name << " changed, running all tests." << std::endl;
+            return allTests();
+        }
+    }
 
-    // Generate CMakeLists.txt with Conan support
-    std::string cmakeContent = R"(
-cmake_minimum_required(VERSION 3.10)
-project()" + projectName + R"( VERSION 1.0 LANGUAGES CXX)
+    auto sources = targetSourceDependencies(buildDir);
+    if (sources.empty()) {
+        std::cout << "No dependency information in " << buildDir << " yet, running all tests." << std::endl;
+        return allTests();
+    }
 
-# Run Conan to install dependencies
-if(NOT EXISTS "${CMAKE_BINARY_DIR}/conanbuildinfo.cmake")
-    message(STATUS "Running Conan to install dependencies...")
-    execute_process(
-        COMMAND conan install ${CMAKE_SOURCE_DIR} --build=missing
-        WORKING_DIRECTORY ${CMAKE_BINARY_DIR}
-        RESULT_VARIABLE CONAN_RESULT
-    )
-    if(NOT CONAN_RESULT EQUAL 0)
-        message(FATAL_ERROR "Conan failed to install dependencies.")
-    endif()
-endif()
+    std::set<std::string> dirty;
+    for (const auto& [target, files] : sources) {
+        for (const auto& file : changed) {
+            if (files.count(file)) {
+                dirty.insert(target);
+                break;
+            }
+        }
+    }
 
-# Include Conan-generated files
-include(${CMAKE_BINARY_DIR}/conanbuildinfo.cmake)
-conan_basic_setup()
+    // A target is also affected when anything it links against is
+    auto links = targetLinkDependencies(buildDir);
+    for (bool grew = true; grew;) {
+        grew = false;
+        for (const auto& [target, libraries] : links) {
+            if (dirty.count(target)) {
+                continue;
+            }
+            for (const auto& library : libraries) {
+                if (dirty.count(library)) {
+                    grew = dirty.insert(target).second;
+                    break;
+                }
+            }
+        }
+    }
 
-set(CMAKE_CXX_STANDARD 17)
-set(CMAKE_CXX_STANDARD_REQUIRED ON)
+    for (const auto& test : tests) {
+        if (test.command.empty()) {
+            continue;
+        }
+        std::string executable = fs::path(test.command[0]).filename().string();
+        // Tests that run something the build does not produce (scripts, tools) cannot be analyzed
+        bool known = sources.count(executable) || links.count(executable);
+        if (dirty.count(executable) || !known) {
+            names.push_back(test.name);
+        }
+    }
+    std::cout << changed.size() << " files changed since " << ref << ", " << dirty.size() << " targets and "
+              << names.size() << " of " << tests.size() << " tests affected." << std::endl;
+    return true;
+}
 
-include_directories(include)
+void ProjectManager::watchProject(const BuildOptions& options, unsigned debounceMs) {
+    FileWatcher watcher(projectName);
+    if (!watcher.valid()) {
+        std::cerr << "Failed to initialize inotify." << std::endl;
+        return;
+    }
 
-add_executable()" + projectName + R"( src/main.cpp)
+    std::string buildDir = projectName + "/build";
+    std::cout << "Watching src/, include/, test/, bench/ and CMakeLists.txt. Press Ctrl+C to stop." << std::endl;
+    buildProject(options);
 
-# Link Conan dependencies
-target_link_libraries()" + projectName + R"( ${CONAN_LIBS})
-)";
-    createFile(projectName + "/CMakeLists.txt", cmakeContent);
+    while (true) {
+        // Block until the first relevant change, then drain events until the burst goes quiet
+        std::chrono::steady_clock::time_point firstChange;
+        bool changed = false;
+        pollfd pfd{watcher.descriptor(), POLLIN, 0};
+        while (poll(&pfd, 1, changed ? static_cast<int>(debounceMs) : -1) > 0) {
+            if (watcher.readChanges() && !changed) {
+                firstChange = std::chrono::steady_clock::now();
+                changed = true;
+            }
+        }
+        if (!changed) {
+            continue;
+        }
 
-    // Create main.cpp
-    std::string mainContent = R"(
-#include <iostream>
+        // Tests whose executables get relinked by this build are the affected ones
+        auto tests = listTests(buildDir);
+        std::map<std::string, fs::file_time_type> before;
+        for (const auto& test : tests) {
+            std::error_code ec;
+            if (!test.command.empty()) {
+                before[test.name] = fs::last_write_time(test.command[0], ec);
+            }
+        }
 
-int main() {
-    std::cout << "Hello, World!" << std::endl;
-    return 0;
+        std::cout << "\nChange detected, rebuilding..." << std::endl;
+        bool green = buildProject(options);
+
+        std::vector<std::string> affected;
+        for (const auto& test : listTests(buildDir)) {
+            std::error_code ec;
+            if (test.command.empty()) {
+                continue;
+            }
+            auto written = fs::last_write_time(test.command[0], ec);
+            if (!before.count(test.name) || (!ec && written != before[test.name])) {
+                affected.push_back(test.name);
+            }
+        }
+        if (green && !affected.empty()) {
+            std::cout << "Running " << affected.size() << " affected tests..." << std::endl;
+            TestOptions testOptions;
+            testOptions.jobs = options.jobs;
+            testOptions.names = affected;
+            green = runTests(testOptions) == 0;
+        }
+
+        double latency = secondsSince(firstChange);
+        std::cout << (green ? "Green" : "Red") << " " << latency * 1000.0 << " ms after save ("
+                  << affected.size() << " tests affected)" << std::endl;
+    }
 }
-)";
-    createFile(projectName + "/src/main.cpp", mainContent);
 
-    std::cout << "Project initialized successfully!" << std::endl;
+void ProjectManager::createHeader(const std::string& headerName) {
+    std::string headerPath = projectName + "/include/" + headerName + ".h";
+    createFile(headerPath, headerSource(headerName));
+    std::cout << "Header file created: " << headerPath << std::endl;
 }
 
-bool ProjectManager::promptToInstallPackageManager() {
-    std::string response;
-    std::cout << "Do you want to install the package manager (Conan)? [y/N]: ";
-    std::getline(std::cin, response);
+void ProjectManager::createModule(const std::string& moduleName, bool createHeader, bool cxxModule) {
+    if (cxxModule) {
+        // The interface unit takes the place of the header
+        if (createHeader) {
+            std::cerr << "--header and --cxx-module cannot be combined; a module interface unit replaces the header."
+                      << std::endl;
+            return;
+        }
+        std::string interfacePath = projectName + "/src/" + moduleName + ".cppm";
+        createFile(interfacePath, moduleInterfaceSource(moduleName));
+        std::cout << "Module interface unit created: " << interfacePath << " (import " << cxxModuleName(moduleName)
+                  << ";)" << std::endl;
+        updateTargetGraph();
+        return;
+    }
 
-    // Default to 'N' if the response is empty
-    if (response.empty() || (response[0] != 'y' && response[0] != 'Y')) {
-        std::cout << "Skipping package manager installation." << std::endl;
-        return false;
+    std::string cppPath = projectName + "/src/" + moduleName + ".cpp";
+    std::string headerPath = projectName + "/include/" + moduleName + ".h";
+    FileBatch files;
+    files.write(cppPath, moduleSource(moduleName, createHeader));
+    if (createHeader) {
+        files.write(headerPath, headerSource(moduleName));
+    }
+    if (!files.commit()) {
+        return;
     }
 
-    std::cout << "Installing Conan..." << std::endl;
-    return true;
+    std::cout << "Module file created: " << cppPath << std::endl;
+    if (createHeader) {
+        std::cout << "Header file created: " << headerPath << std::endl;
+    }
+    updateTargetGraph();
 }
 
-void ProjectManager::setupPythonVirtualEnv() {
-    // Path to the virtual environment in the project root folder
-    std::string venvPath = projectName + "/manager";
+bool ProjectManager::migrateToModules(const std::vector<std::string>& headers) {
+    // Top-level and nested headers under include/, by name ("util", "net/socket") or path
+    std::vector<std::string> names;
+    for (std::string header : headers) {
+        if (header.rfind("include/", 0) == 0) {
+            header = header.substr(8);
+        }
+        fs::path path(header);
+        names.push_back(path.extension() == ".h" || path.extension() == ".hpp"
+                            ? path.replace_extension().string() : header);
+    }
+    std::error_code ec;
+    if (headers.empty()) {
+        for (auto it = fs::recursive_directory_iterator(projectName + "/include", ec);
+             !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            fs::path relative = it->path().lexically_relative(projectName + "/include");
+            // The precompiled header only gathers system headers
+            if ((relative.extension() == ".h" || relative.extension() == ".hpp") && relative != "pch.h") {
+                names.push_back(fs::path(relative).replace_extension().string());
+            }
+        }
+        std::sort(names.begin(), names.end());
+    }
 
-    // Check if the virtual environment already exists
-    if (fs::exists(venvPath)) {
-        std::cout << "Virtual environment already exists at " << venvPath << std::endl;
-        return;
+    auto read = [](const std::string& path) {
+        std::ifstream in(path);
+        return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    };
+    auto lines = [](const std::string& content) {
+        std::vector<std::string> result;
+        std::istringstream in(content);
+        for (std::string line; std::getline(in, line);) {
+            result.push_back(line);
+        }
+        return result;
+    };
+    auto directive = [](const std::string& line) {
+        std::istringstream words(line);
+        std::string word;
+        words >> word;
+        if (word == "#") {
+            words >> word;
+            return word;
+        }
+        return word.size() > 1 && word[0] == '#' ? word.substr(1) : std::string();
+    };
+
+    // A header can become a named module when nothing in it depends on staying textual: a module exports
+    // no macros, internal-linkage names or conditional includes
+    std::map<std::string, std::string> headerPaths; // module path -> project-relative header
+    std::map<std::string, std::vector<std::string>> bodies;
+    for (const auto& name : names) {
+        std::string headerPath;
+        for (const char* extension : {".h", ".hpp"}) {
+            if (headerPath.empty() && fs::exists(projectName + "/include/" + name + extension)) {
+                headerPath = "include/" + name + extension;
+            }
+        }
+        if (headerPath.empty()) {
+            std::cerr << "No header include/" << name << ".h to migrate." << std::endl;
+            return false;
+        }
+        if (fs::exists(projectName + "/src/" + name + ".cppm")) {
+            std::cerr << "src/" << name << ".cppm already exists; skipping " << headerPath << "." << std::endl;
+            continue;
+        }
+
+        std::vector<std::string> body = lines(read(projectName + "/" + headerPath));
+        // Drop the include guard or #pragma once
+        auto first = std::find_if(body.begin(), body.end(), [&](const std::string& line) { return !directive(line).empty(); });
+        if (first != body.end() && directive(*first) == "pragma" && first->find("once") != std::string::npos) {
+            body.erase(first);
+        } else if (first != body.end() && directive(*first) == "ifndef") {
+            auto define = std::find_if(first + 1, body.end(), [&](const std::string& line) { return !directive(line).empty(); });
+            auto last = std::find_if(body.rbegin(), body.rend(), [&](const std::string& line) { return !directive(line).empty(); });
+            if (define != body.end() && directive(*define) == "define" && last != body.rend() &&
+                directive(*last) == "endif") {
+                body.erase(std::next(last).base());
+                body.erase(define);
+                body.erase(first);
+            }
+        }
+
+        std::string reason;
+        int depth = 0;
+        // Per open brace whether it opened a namespace or extern "C" block; static members of classes export fine
+        std::vector<bool> scopes;
+        std::string opener; // the text since the last ';', '{' or '}'
+        auto hasWord = [](const std::string& text, const std::string& word) {
+            for (size_t pos = text.find(word); pos != std::string::npos; pos = text.find(word, pos + 1)) {
+                size_t end = pos + word.size();
+                if ((pos == 0 || !isIdentifierChar(text[pos - 1])) &&
+                    (end == text.size() || !isIdentifierChar(text[end]))) {
+                    return true;
+                }
+            }
+            return false;
+        };
+        for (const auto& line : body) {
+            std::string name = directive(line);
+            std::string code = line.substr(std::min(line.size(), line.find_first_not_of(" \t")));
+            depth += (name == "if" || name == "ifdef" || name == "ifndef") - (name == "endif");
+            // static as a word of its own; static_assert is fine inside the export block
+            bool namespaceScope = std::find(scopes.begin(), scopes.end(), false) == scopes.end();
+            bool staticDeclaration = namespaceScope && code.compare(0, 6, "static") == 0 &&
+                                     (code.size() == 6 || !isIdentifierChar(code[6]));
+            std::string braces = name.empty() ? code.substr(0, code.find("//")) : "";
+            for (char c : braces) {
+                if (c == '{') {
+                    scopes.push_back(hasWord(opener, "namespace") || hasWord(opener, "extern"));
+                } else if (c == '}' && !scopes.empty()) {
+                    scopes.pop_back();
+                }
+                opener = c == '{' || c == '}' || c == ';' ? "" : opener + c;
+            }
+            opener += ' ';
+            if (name == "define") {
+                reason = "it defines macros, which importers would not see";
+            } else if (name == "include" && depth > 0) {
+                reason = "it includes headers conditionally";
+            } else if (staticDeclaration || code.find("namespace {") != std::string::npos) {
+                reason = "it has namespace-scope static declarations or unnamed namespaces, which cannot be exported";
+            }
+            if (!reason.empty()) {
+                break;
+            }
+        }
+        if (!reason.empty()) {
+            std::cerr << "Keeping " << headerPath << " as a header: " << reason << "." << std::endl;
+            continue;
+        }
+        headerPaths[name] = headerPath;
+        bodies[name] = body;
+    }
+    if (headerPaths.empty()) {
+        std::cout << "No headers migrated." << std::endl;
+        return true;
     }
 
-    // Create Python virtual environment
-    std::string createVenvCommand = "python3 -m venv " + venvPath;
-    executeCommandWithOutput(createVenvCommand);
+    // Includes of migrated headers become imports: after the module declaration in module units, in place
+    // elsewhere. Returns the other includes of a module unit in front, for its global module fragment.
+    auto migratedHeader = [&](const std::string& from, const std::string& line) {
+        auto parsed = IncludeGraph::parse(line.data(), line.size());
+        if (parsed.empty() || directive(line) != "include") {
+            return std::string();
+        }
+        std::string target = IncludeGraph::resolve(from, parsed[0], [&](const std::string& path) {
+            return fs::exists(projectName + "/" + path);
+        });
+        for (const auto& [name, headerPath] : headerPaths) {
+            if (target == headerPath) {
+                return name;
+            }
+        }
+        return std::string();
+    };
+
+    FileBatch files;
+    std::set<std::string> importers;
+    // Names from the interface's global module fragment are not visible in the implementation unit
+    std::map<std::string, std::vector<std::string>> headerIncludes;
+    for (const auto& [name, headerPath] : headerPaths) {
+        std::string includes, imports, exported;
+        for (const auto& line : bodies[name]) {
+            std::string imported = migratedHeader(headerPath, line);
+            if (!imported.empty()) {
+                imports += "export import " + cxxModuleName(imported) + ";\n";
+            } else if (directive(line) == "include") {
+                includes += line + "\n";
+                headerIncludes[name].push_back(line);
+            } else {
+                exported += line + "\n";
+            }
+        }
+        // Trim the blank lines the guard left behind
+        exported.erase(0, exported.find_first_not_of('\n'));
+        exported.erase(exported.find_last_not_of('\n') + 1);
+        files.write(projectName + "/src/" + name + ".cppm",
+                    "module;\n\n" + includes + (includes.empty() ? "" : "\n") + "export module " + cxxModuleName(name) +
+                        ";\n\n" + imports + (imports.empty() ? "" : "\n") + "export {\n" + exported + "\n}\n");
+    }
 
-    // Install Conan in the virtual environment
-    std::string installConanCommand = venvPath + "/bin/pip install conan";
-    executeCommandWithOutput(installConanCommand);
+    std::vector<std::string> projectSources;
+    for (const char* dir : {"src", "include", "test", "bench"}) {
+        for (auto it = fs::recursive_directory_iterator(projectName + "/" + dir, ec);
+             !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            if (it->is_regular_file()) {
+                projectSources.push_back(it->path().lexically_relative(projectName).string());
+            }
+        }
+        ec.clear();
+    }
+    for (const auto& file : projectSources) {
+        std::string extension = fs::path(file).extension().string();
+        bool migratedAway = std::any_of(headerPaths.begin(), headerPaths.end(),
+                                        [&](const auto& entry) { return entry.second == file; });
+        if (migratedAway || (!IncludeGraph::isSource(file) && extension != ".h" && extension != ".hpp")) {
+            continue;
+        }
+        std::vector<std::string> content = lines(read(projectName + "/" + file));
+        std::string stem = fs::path(file).lexically_relative("src").replace_extension().string();
+        bool implementation = extension != ".cppm" && headerPaths.count(stem) && file.rfind("src/", 0) == 0;
+
+        // The implementation file of a migrated header becomes its module implementation unit
+        size_t declaration = content.size();
+        for (size_t i = 0; i < content.size() && declaration == content.size(); ++i) {
+            if (!declaredModule(content[i]).empty()) {
+                declaration = i;
+            }
+        }
+        bool moduleUnit = declaration < content.size() || implementation;
+        std::vector<std::string> fragment = implementation ? headerIncludes[stem] : std::vector<std::string>();
+        std::vector<std::string> imports, rest;
+        bool changed = implementation;
+        for (size_t i = 0; i < content.size(); ++i) {
+            std::string imported = migratedHeader(file, content[i]);
+            if (!imported.empty()) {
+                changed = true;
+                if (!(implementation && imported == stem)) {
+                    (moduleUnit ? imports : rest).push_back("import " + cxxModuleName(imported) + ";");
+                }
+            } else if (implementation && directive(content[i]) == "include") {
+                if (std::find(fragment.begin(), fragment.end(), content[i]) == fragment.end()) {
+                    fragment.push_back(content[i]);
+                }
+            } else if (!(implementation && i < declaration && content[i] == "module;")) {
+                rest.push_back(content[i]);
+            }
+        }
+        if (!changed) {
+            continue;
+        }
+        importers.insert(file);
+        std::string result;
+        if (implementation) {
+            result = "module;\n\n";
+            for (const auto& line : fragment) {
+                result += line + "\n";
+            }
+            result += (fragment.empty() ? "" : "\n") + std::string("module ") + cxxModuleName(stem) + ";\n";
+            for (const auto& line : imports) {
+                result += line + "\n";
+            }
+            for (const auto& line : rest) {
+                result += line + "\n";
+            }
+        } else {
+            for (size_t i = 0; i < rest.size(); ++i) {
+                result += rest[i] + "\n";
+                // In a module unit imports follow the module declaration
+                if (moduleUnit && !declaredModule(rest[i]).empty()) {
+                    for (const auto& line : imports) {
+                        result += line + "\n";
+                    }
+                }
+            }
+        }
+        files.write(projectName + "/" + file, result);
+    }
+    if (!files.commit()) {
+        return false;
+    }
+    for (const auto& [name, headerPath] : headerPaths) {
+        deleteFile(projectName + "/" + headerPath);
+        std::cout << headerPath << " -> src/" << name << ".cppm (module " << cxxModuleName(name) << ")" << std::endl;
+    }
+    std::cout << "Migrated " << headerPaths.size() << " headers; " << importers.size()
+              << " files now import them. Building needs CMake 3.28, Ninja 1.11 and GCC 14 or Clang 16." << std::endl;
+    updateTargetGraph();
+    return true;
+}
 
-    std::cout << "Python virtual environment created and Conan installed in " << venvPath << std::endl;
+bool ProjectManager::usesCxxModules() {
+    std::error_code ec;
+    for (auto it = fs::recursive_directory_iterator(projectName + "/src", ec);
+         !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        if (it->path().extension() == ".cppm") {
+            return true;
+        }
+    }
+    return false;
 }
 
-void ProjectManager::addDependency(const std::string& dependency) {
-    // Update conanfile.txt with the new dependency
+bool ProjectManager::createBenchmark(const std::string& benchName) {
+    std::string benchPath = projectName + "/bench/" + benchName + ".cpp";
+    if (fs::exists(benchPath)) {
+        std::cerr << "Benchmark already exists: " << benchPath << std::endl;
+        return false;
+    }
+    FileBatch files;
+    files.write(benchPath, benchSource(benchName));
+
+    // Conan projects get Google Benchmark from Conan; CMakeDeps writes the config find_package() needs.
+    // It is installed by the next build, like any other change to conanfile.txt.
     std::string conanfilePath = projectName + "/conanfile.txt";
     std::ifstream conanfileIn(conanfilePath);
-    std::string conanfileContent((std::istreambuf_iterator<char>(conanfileIn)), std::istreambuf_iterator<char>());
-    conanfileIn.close();
-
-    // Add the dependency to the [requires] section
-    size_t requiresPos = conanfileContent.find("[requires]");
-    if (requiresPos != std::string::npos) {
-        size_t insertPos = conanfileContent.find("\n", requiresPos) + 1;
-        conanfileContent.insert(insertPos, dependency + "\n");
+    if (conanfileIn) {
+        std::string content((std::istreambuf_iterator<char>(conanfileIn)), std::istreambuf_iterator<char>());
+        if (content.find("\nbenchmark/") == std::string::npos) {
+            content = withRequirements(content, {kBenchmarkPackage});
+        }
+        files.write(conanfilePath, withGenerator(content, "CMakeDeps"));
+    }
+    if (!files.commit()) {
+        return false;
     }
+    wireBenchmarks();
+
+    std::cout << "Benchmark created: " << benchPath << std::endl;
+    std::cout << "Run it with `cpp-manager bench`." << std::endl;
+    return true;
+}
 
-    // Write the updated conanfile.txt
-    std::ofstream conanfileOut(conanfilePath);
-    conanfileOut << conanfileContent;
-    conanfileOut.close();
+// Set in the daemon, which refreshes it after every change before a request forks
+static std::unique_ptr<IncludeGraph> residentGraph;
 
-    // Install the dependency using Conan
-    std::string installCommand = "cd " + projectName + " && source manager/bin/activate && conan install . --build=missing";
-    executeCommandWithOutput(installCommand);
+void ProjectManager::warmResidentState() {
+    createDirectory(projectName + "/build/.cpp-manager");
+    if (!residentGraph) {
+        residentGraph = std::make_unique<IncludeGraph>(projectName);
+    }
+    residentGraph->update(projectName + "/build/.cpp-manager/include-index");
+}
 
-    dependencies.push_back(dependency);
-    std::cout << "Added dependency: " << dependency << std::endl;
+IncludeGraph ProjectManager::includeGraph() {
+    if (residentGraph) {
+        return *residentGraph;
+    }
+    createDirectory(projectName + "/build/.cpp-manager");
+    IncludeGraph graph(projectName);
+    graph.update(projectName + "/build/.cpp-manager/include-index");
+    return graph;
 }
 
-void ProjectManager::buildProject() {
-    executeCommand("cd " + projectName + " && mkdir -p build && cd build && cmake .. && make");
-    std::cout << "Project built successfully!" << std::endl;
+bool ProjectManager::depsCommand(const std::string& query, const std::string& argument, size_t limit) {
+    auto start = std::chrono::steady_clock::now();
+    IncludeGraph graph = includeGraph();
+    double indexMs = secondsSince(start) * 1000;
+
+    // Files can be named by project-relative path or by any trailing part of it, e.g. "util.h"
+    auto find = [&](const std::string& name) {
+        std::vector<std::string> matches;
+        for (const auto& file : graph.files()) {
+            if (file == name) {
+                return std::vector<std::string>{file};
+            }
+            if (file.size() > name.size() && file.compare(file.size() - name.size(), name.size(), name) == 0 &&
+                file[file.size() - name.size() - 1] == '/') {
+                matches.push_back(file);
+            }
+        }
+        return matches;
+    };
+
+    if (query == "graph") {
+        bool dot = argument == "--dot";
+        if (dot) {
+            std::cout << "digraph includes {" << std::endl;
+        }
+        for (const auto& file : graph.files()) {
+            auto includes = graph.includes(file);
+            if (!dot) {
+                std::cout << file << std::endl;
+            }
+            for (const auto& include : includes) {
+                if (dot) {
+                    std::cout << "  \"" << file << "\" -> \"" << include << "\";" << std::endl;
+                } else {
+                    std::cout << "  " << include << std::endl;
+                }
+            }
+        }
+        if (dot) {
+            std::cout << "}" << std::endl;
+        }
+    } else if (query == "rdeps") {
+        auto matches = find(argument);
+        if (matches.size() != 1) {
+            std::cerr << (matches.empty() ? "No indexed file matches " : "Ambiguous file name ") << argument
+                      << std::endl;
+            for (const auto& match : matches) {
+                std::cerr << "  " << match << std::endl;
+            }
+            return false;
+        }
+        auto includers = graph.includers(matches[0]);
+        size_t units = 0;
+        for (const auto& file : includers) {
+            bool unit = IncludeGraph::isSource(file);
+            units += unit;
+            std::cout << (unit ? "  " : "  (header) ") << file << std::endl;
+        }
+        std::cout << matches[0] << " is included by " << includers.size() << " files, " << units
+                  << " translation units recompile when it changes" << std::endl;
+    } else if (query == "fanout") {
+        auto ranking = graph.fanout();
+        for (size_t i = 0; i < std::min(limit, ranking.size()) && ranking[i].second > 0; ++i) {
+            std::cout << std::setw(6) << ranking[i].second << "  " << ranking[i].first << std::endl;
+        }
+    } else if (query == "cycles") {
+        auto cycles = graph.cycles();
+        for (const auto& cycle : cycles) {
+            std::string chain;
+            for (const auto& file : cycle) {
+                chain += file + " -> ";
+            }
+            std::cout << "  " << chain << cycle.front() << std::endl;
+        }
+        std::cout << cycles.size() << " include cycles" << std::endl;
+    } else {
+        std::cerr << "Unknown deps query: " << query << std::endl;
+        return false;
+    }
+
+    std::cerr << "Indexed " << graph.files().size() << " files (" << graph.reparsed() << " re-parsed) in "
+              << std::fixed << std::setprecision(1) << indexMs << " ms" << std::endl;
+    return true;
 }
 
-void ProjectManager::runTests() {
-    executeCommand("cd " + projectName + "/build && ctest");
-    std::cout << "Tests executed successfully!" << std::endl;
+void ProjectManager::updateTargetGraph() {
+    std::string cmakePath = projectName + "/CMakeLists.txt";
+    std::ifstream in(cmakePath);
+    std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+
+    // Projects without the generated block keep their hand-written targets
+    if (!TargetGraph::hasBlock(content)) {
+        return;
+    }
+    TargetGraph graph = TargetGraph::fromIncludeGraph(includeGraph());
+    TargetGraph::splice(content, graph.cmakeBlock(projectTargetName()));
+    for (const auto& [from, to] : graph.droppedEdges()) {
+        std::cerr << "Warning: include cycle between modules " << from << " and " << to << "; not linking " << from
+                  << " to " << to << std::endl;
+    }
+    createFile(cmakePath, content);
 }
 
-void ProjectManager::createHeader(const std::string& headerName) {
-    std::string headerPath = projectName + "/include/" + headerName + ".h";
+std::string ProjectManager::headerSource(const std::string& headerName) {
     std::string headerGuard = headerName;
     std::transform(headerGuard.begin(), headerGuard.end(), headerGuard.begin(), [](unsigned char c) {
         return std::toupper(c);
     });
     headerGuard += "_H";
 
-    std::string headerContent = R"(
+    return R"(
 #ifndef )" + headerGuard + R"(
 #define )" + headerGuard + R"(
 
@@ -172,23 +3497,49 @@ void ProjectManager::createHeader(const std::string& headerName) {
 
 #endif // )" + headerGuard + R"(
 )";
-    createFile(headerPath, headerContent);
-    std::cout << "Header file created: " << headerPath << std::endl;
 }
 
-void ProjectManager::createModule(const std::string& moduleName, bool createHeader) {
-    std::string cppPath = projectName + "/src/" + moduleName + ".cpp";
-    std::string cppContent = R"(
-#include ")" + (createHeader ? (moduleName + ".h") : "") + R"("
-
+std::string ProjectManager::moduleSource(const std::string& moduleName, bool withHeader) {
+    return (withHeader ? "\n#include \"" + moduleName + ".h\"\n" : "") + R"(
 // Your code here
 )";
-    createFile(cppPath, cppContent);
-    std::cout << "Module file created: " << cppPath << std::endl;
+}
 
-    if (createHeader) {
-        this->createHeader(moduleName);
+std::string ProjectManager::moduleInterfaceSource(const std::string& moduleName) {
+    return R"(module;
+
+// #include directives for this module go here, in the global module fragment
+
+export module )" + cxxModuleName(moduleName) + R"(;
+
+// Your code here; what is declared `export` is visible where the module is imported
+)";
+}
+
+std::string ProjectManager::benchSource(const std::string& benchName) {
+    std::string identifier = "BM_";
+    for (char c : benchName) {
+        identifier += std::isalnum(static_cast<unsigned char>(c)) ? c : '_';
+    }
+
+    return R"(
+#include <benchmark/benchmark.h>
+
+#include <numeric>
+#include <vector>
+
+// Replace the loop body with the code to measure; state.range(0) is the input size
+static void )" + identifier + R"((benchmark::State& state) {
+    std::vector<int> values(state.range(0));
+    std::iota(values.begin(), values.end(), 0);
+    for (auto _ : state) {
+        // Keep the result alive, or the optimizer removes the work
+        benchmark::DoNotOptimize(std::accumulate(values.begin(), values.end(), 0));
     }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK()" + identifier + R"()->Range(8, 8 << 10);
+)";
 }
 
 void ProjectManager::deleteModule(const std::string& moduleName) {
@@ -197,6 +3548,8 @@ void ProjectManager::deleteModule(const std::string& moduleName) {
 
     deleteFile(cppPath);
     deleteFile(headerPath);
+    deleteFile(projectName + "/src/" + moduleName + ".cppm");
+    updateTargetGraph();
 
     std::cout << "Module deleted: " << moduleName << std::endl;
 }
@@ -206,32 +3559,34 @@ void ProjectManager::createDirectory(const std::string& path) {
 }
 
 void ProjectManager::createFile(const std::string& path, const std::string& content) {
-    std::ofstream file(path);
-    file << content;
-    file.close();
-}
-
-void ProjectManager::executeCommand(const std::string& command) {
-    std::system(command.c_str());
+    FileBatch batch;
+    batch.write(path, content);
+    batch.commit();
 }
 
-void ProjectManager::executeCommandWithOutput(const std::string& command) {
-    char buffer[128];
-    std::string fullCommand = "/bin/bash -c '" + command + "'"; // Use bash to handle 'source'
-    FILE* pipe = popen(fullCommand.c_str(), "r");
-    if (!pipe) {
-        std::cerr << "Failed to execute command: " << command << std::endl;
-        return;
+void ProjectManager::writeFiles(const std::map<std::string, std::string>& files) {
+    FileBatch batch;
+    for (const auto& [path, content] : files) {
+        batch.write(projectName + "/" + path, content);
     }
+    batch.commit();
+}
 
-    while (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
-        std::cout << buffer; // Print the output in real-time
-    }
+int ProjectManager::executeCommand(const std::vector<std::string>& argv, const std::string& workingDirectory) {
+    ProcessSpec spec;
+    spec.argv = argv;
+    spec.workingDirectory = workingDirectory;
+    return Process::run(spec).exitCode;
+}
 
-    int status = pclose(pipe);
-    if (status != 0) {
-        std::cerr << "Command failed with exit code: " << status << std::endl;
-    }
+std::string ProjectManager::captureCommandOutput(const std::vector<std::string>& argv,
+                                                 const std::string& workingDirectory) {
+    ProcessSpec spec;
+    spec.argv = argv;
+    spec.workingDirectory = workingDirectory;
+    spec.stdoutMode = ProcessOutput::Capture;
+    spec.stderrMode = ProcessOutput::Discard;
+    return Process::run(spec).out;
 }
 
 void ProjectManager::deleteFile(const std::string& path) {
@@ -242,8 +3597,9 @@ void ProjectManager::deleteFile(const std::string& path) {
 
 void ProjectManager::srcCommand(const std::string& subCommand) {
     if (subCommand == "--list") {
-        listSourceFiles();
+        listSourceFiles(SourceOptions());
     } else {
+        performanceCodegen = subCommand == "--perf";
         std::string fileName;
         std::cout << "Enter the file name (e.g., query.cpp): ";
         std::getline(std::cin, fileName);
@@ -257,15 +3613,97 @@ void ProjectManager::srcCommand(const std::string& subCommand) {
     }
 }
 
-void ProjectManager::listSourceFiles() {
-    std::string srcPath = projectName + "/src";
-    std::cout << "Source files in " << srcPath << ":" << std::endl;
+std::vector<SourceFile> ProjectManager::sourceFiles(SourceIndex& index, const SourceOptions& options) {
+    std::set<std::string> changed;
+    if (!options.changedSince.empty()) {
+        if (captureCommandOutput({"git", "rev-parse", "--git-dir"}, projectName).empty()) {
+            std::cerr << "--changed-since needs a git repository." << std::endl;
+            return {};
+        }
+        for (const auto& file : changedFiles(options.changedSince)) {
+            changed.insert(file);
+        }
+    }
+    std::string root = fs::absolute(projectName).lexically_normal().string();
+
+    std::vector<SourceFile> files;
+    for (const auto& file : index.files()) {
+        if (!options.extensions.empty()) {
+            std::string extension = fs::path(file.path).extension().string();
+            bool wanted = false;
+            for (const auto& candidate : options.extensions) {
+                wanted = wanted || extension == (candidate[0] == '.' ? candidate : "." + candidate);
+            }
+            if (!wanted) {
+                continue;
+            }
+        }
+        if (!options.module.empty() && TargetGraph::moduleOf(file.path) != options.module) {
+            continue;
+        }
+        if (!options.changedSince.empty() && !changed.count((fs::path(root) / file.path).lexically_normal().string())) {
+            continue;
+        }
+        files.push_back(file);
+    }
+    return files;
+}
+
+bool ProjectManager::listSourceFiles(const SourceOptions& options) {
+    auto start = std::chrono::steady_clock::now();
+    createDirectory(projectName + "/build/.cpp-manager");
+    SourceIndex index(projectName);
+    index.update(projectName + kSourceSnapshot, false);
+
+    auto files = sourceFiles(index, options);
+    for (const auto& file : files) {
+        std::cout << file.path << "\n";
+    }
+    std::cout.flush();
+    std::cerr << "Listed " << files.size() << " of " << index.files().size() << " files ("
+              << index.directoriesRead() << " directories read) in " << std::fixed << std::setprecision(1)
+              << secondsSince(start) * 1000 << " ms" << std::endl;
+    return true;
+}
 
-    for (const auto& entry : fs::directory_iterator(srcPath)) {
-        if (entry.path().extension() == ".cpp") {
-            std::cout << "  " << entry.path().filename().string() << std::endl;
+bool ProjectManager::grepSourceFiles(const std::string& text, const SourceOptions& options) {
+    if (text.empty()) {
+        std::cerr << "Usage: cpp-manager src --grep <text>" << std::endl;
+        return false;
+    }
+    auto start = std::chrono::steady_clock::now();
+    createDirectory(projectName + "/build/.cpp-manager");
+    SourceIndex index(projectName);
+    index.update(projectName + kSourceSnapshot, true);
+    index.updateTrigrams(projectName + kTrigramIndex);
+
+    // Only the files holding every trigram of text are opened; the filters then apply to those
+    std::set<std::string> wanted;
+    for (const auto& file : sourceFiles(index, options)) {
+        wanted.insert(file.path);
+    }
+    auto candidates = index.candidates(text);
+    size_t matches = 0, opened = 0;
+    for (size_t i : candidates) {
+        const std::string& path = index.files()[i].path;
+        if (!wanted.count(path)) {
+            continue;
+        }
+        ++opened;
+        std::ifstream in(projectName + "/" + path);
+        std::string line;
+        for (size_t number = 1; std::getline(in, line); ++number) {
+            if (line.find(text) != std::string::npos) {
+                std::cout << path << ":" << number << ": " << line << "\n";
+                ++matches;
+            }
         }
     }
+    std::cout.flush();
+    std::cerr << matches << " matches in " << opened << " of " << index.files().size() << " files ("
+              << index.filesReindexed() << " re-indexed) in " << std::fixed << std::setprecision(1)
+              << secondsSince(start) * 1000 << " ms" << std::endl;
+    return true;
 }
 
 void ProjectManager::editSourceFile(const std::string& fileName) {
@@ -274,12 +3712,10 @@ void ProjectManager::editSourceFile(const std::string& fileName) {
      // Check if the file is being created for the first time
     bool isNewFile = !fs::exists(filePath);
 
-    // Create the file if it doesn't exist
+    // Everything entered is kept in memory and written once when editing ends
+    FileBatch batch;
     if (isNewFile) {
-        std::ofstream file(filePath);
-        file << "#include <iostream>\n\n"; // Include iostream for new files
-        file.close();
-        std::cout << "Created file: " << filePath << std::endl;
+        batch.write(filePath, "#include <iostream>\n\n"); // Include iostream for new files
     }
 
     std::cout << "Editing file: (" << fileName << ")" << std::endl;
@@ -287,41 +3723,43 @@ void ProjectManager::editSourceFile(const std::string& fileName) {
     while (true) {
         std::string input;
         std::cout << "Enter class/struct/function [name] (or 'quit' to exit): ";
-        std::getline(std::cin, input);
-
-        if (input == "quit") {
+        if (!std::getline(std::cin, input) || input == "quit") {
             break;
         }
 
         if (input.find("class") == 0 || input.find("struct") == 0) {
             std::string type = input.substr(0, input.find(' '));
             std::string name = input.substr(input.find(' ') + 1);
-            std::string code = createClassOrStructPrompt(type, name);
-            std::ofstream file(filePath, std::ios::app);
-            file << code << std::endl;
-            file.close();
+            batch.append(filePath, createClassOrStructPrompt(type, name) + "\n");
         } else if (input.find("function") == 0) {
             std::string name = input.substr(input.find(' ') + 1);
-            std::string code = createFunctionPrompt(name);
-            std::ofstream file(filePath, std::ios::app);
-            file << code << std::endl;
-            file.close();
+            batch.append(filePath, createFunctionPrompt(name) + "\n");
         } else {
             std::cerr << "Invalid input. Use 'class', 'struct', or 'function'." << std::endl;
         }
     }
+
+    if (performanceCodegen) {
+        batch.write(filePath, withStandardIncludes(batch.content(filePath)));
+    }
+    if (batch.commit() && isNewFile) {
+        std::cout << "Created file: " << filePath << std::endl;
+    }
 }
 
 std::string ProjectManager::createFunctionPrompt(const std::string& name, bool nested) {
-    std::string description;
+    return generateFunction(promptFunction(name), nested);
+}
+
+FunctionSpec ProjectManager::promptFunction(const std::string& name) {
+    FunctionSpec function;
+    function.name = name;
     std::cout << "(" << name << ")Enter function description: ";
-    std::getline(std::cin, description);
+    std::getline(std::cin, function.description);
 
-    std::string returnType;
     std::cout << "(" << name << ")Enter return type: ";
-    std::getline(std::cin, returnType);
+    std::getline(std::cin, function.returnType);
 
-    std::vector<std::pair<std::string, std::string>> parameters;
     while (true) {
         std::string param;
         std::cout << "(" << name << ") Enter parameter (name type) or press Enter to finish: ";
@@ -339,30 +3777,18 @@ std::string ProjectManager::createFunctionPrompt(const std::string& name, bool n
 
         std::string paramName = param.substr(0, space);
         std::string paramType = param.substr(space + 1);
-        parameters.push_back({paramName, paramType});
-    }
-
-    std::string code = returnType + " " + name + "(";
-    for (size_t i = 0; i < parameters.size(); ++i) {
-        code += parameters[i].second + " " + parameters[i].first;
-        if (i < parameters.size() - 1) {
-            code += ", ";
-        }
+        function.parameters.push_back({paramName, paramType});
     }
-    code += ") {\n";
-    code += nested ?"\t// " + description + "\n" : "// " + description + "\n";
-    code += nested ? "\t    // Write your code\n" :"    // Write your code\n";
-    code += nested ? "\t}\n" : "}\n";
-
-    return code;
+    return function;
 }
 
 std::string ProjectManager::createClassOrStructPrompt(const std::string& type, const std::string& name) {
-    std::string description;
+    ClassSpec spec;
+    spec.type = type;
+    spec.name = name;
     std::cout << "(" << name << ") Enter " << type << " description: ";
-    std::getline(std::cin, description);
+    std::getline(std::cin, spec.description);
 
-    std::vector<std::pair<std::string, std::string>> attributes;
     while (true) {
         std::string attr;
         std::cout << "(" << name << ") Enter attribute (name type) or press Enter to finish: ";
@@ -380,14 +3806,14 @@ std::string ProjectManager::createClassOrStructPrompt(const std::string& type, c
 
         std::string attrName = attr.substr(0, space);
         std::string attrType = attr.substr(space + 1);
-        attributes.push_back({attrName, attrType});
+        spec.attributes.push_back({attrName, attrType});
     }
 
-    std::string code = type + " " + name + " {\n";
-    code += "// " + description + "\n";
-    code += "public:\n";
-    for (const auto& attr : attributes) {
-        code += "    " + attr.second + " " + attr.first + ";\n";
+    if (performanceCodegen && !spec.attributes.empty()) {
+        std::string answer;
+        std::cout << "(" << name << ") Also generate a structure-of-arrays container " << name << "SoA? [y/N]: ";
+        std::getline(std::cin, answer);
+        spec.soa = answer == "y" || answer == "Y" || answer == "yes";
     }
 
      // Add methods
@@ -400,11 +3826,128 @@ std::string ProjectManager::createClassOrStructPrompt(const std::string& type, c
             break;
         }
 
-        std::string methodCode = createFunctionPrompt(methodName, true);
+        spec.methods.push_back(promptFunction(methodName));
+    }
+
+    return generateClassOrStruct(spec);
+}
+
+std::string ProjectManager::generateFunction(const FunctionSpec& function, bool nested,
+                                             const std::vector<std::pair<std::string, std::string>>& members) {
+    std::string code = function.returnType + " " + function.name + "(";
+    std::string moves;
+    for (size_t i = 0; i < function.parameters.size(); ++i) {
+        std::string type = function.parameters[i].second;
+        TypeLayout layout;
+        typeLayout(type, layout);
+        // Move-only types stay by value so the function can take ownership; a same-named member gets it
+        if (performanceCodegen && layout.moveOnly) {
+            const std::string& name = function.parameters[i].first;
+            if (std::find(members.begin(), members.end(), function.parameters[i]) != members.end()) {
+                moves += std::string(nested ? "\t    " : "    ") + "this->" + name + " = std::move(" + name + ");\n";
+            }
+        } else if (performanceCodegen && !layout.cheap && type.compare(0, 6, "const ") != 0) {
+            type = "const " + type + "&";
+        }
+        code += type + " " + function.parameters[i].first;
+        if (i < function.parameters.size() - 1) {
+            code += ", ";
+        }
+    }
+    code += ") {\n";
+    code += nested ?"\t// " + function.description + "\n" : "// " + function.description + "\n";
+    code += moves;
+    code += nested ? "\t    // Write your code\n" :"    // Write your code\n";
+    code += nested ? "\t}\n" : "}\n";
+
+    return code;
+}
+
+std::string ProjectManager::generateClassOrStruct(const ClassSpec& spec) {
+    // Widest alignment first leaves padding only at the end; equal alignments keep the order entered
+    auto attributes = spec.attributes;
+    if (performanceCodegen) {
+        std::stable_sort(attributes.begin(), attributes.end(), [](const auto& a, const auto& b) {
+            TypeLayout left, right;
+            typeLayout(a.second, left);
+            typeLayout(b.second, right);
+            return left.align > right.align;
+        });
+        reportLayout(spec.name, spec.attributes, attributes);
+    }
+
+    std::string code = spec.type + " " + spec.name + " {\n";
+    code += "// " + spec.description + "\n";
+    code += "public:\n";
+    for (const auto& attr : attributes) {
+        code += "    " + attr.second + " " + attr.first + ";\n";
+    }
+    // A member without a copy constructor makes the whole type move-only
+    std::string moveOnly;
+    for (const auto& attr : attributes) {
+        TypeLayout layout;
+        if (moveOnly.empty() && typeLayout(attr.second, layout) && layout.moveOnly) {
+            moveOnly = attr.second;
+        }
+    }
+    if (performanceCodegen) {
+        // Sink parameters: expensive members are taken by value and moved into place
+        const std::string& name = spec.name;
+        code += "\n    " + name + "() = default;\n";
+        if (!attributes.empty()) {
+            std::string parameters, initializers;
+            for (const auto& [member, type] : attributes) {
+                TypeLayout layout;
+                typeLayout(type, layout);
+                parameters += (parameters.empty() ? "" : ", ") + type + " " + member;
+                initializers += (initializers.empty() ? "" : ", ") + member +
+                                (layout.cheap ? "(" + member + ")" : "(std::move(" + member + "))");
+            }
+            code += "    " + std::string(attributes.size() == 1 ? "explicit " : "") + name + "(" + parameters +
+                    ")\n        : " + initializers + " {}\n";
+        }
+        std::string copy = moveOnly.empty() ? "default" : "delete";
+        code += "    " + name + "(const " + name + "&) = " + copy + ";\n";
+        code += "    " + name + "(" + name + "&&) noexcept = default;\n";
+        code += "    " + name + "& operator=(const " + name + "&) = " + copy + ";\n";
+        code += "    " + name + "& operator=(" + name + "&&) noexcept = default;\n";
+    }
+    for (const auto& method : spec.methods) {
         code += "\t";
-        code += methodCode;
+        code += generateFunction(method, true, spec.attributes);
     }
     code += "};\n";
 
+    if (performanceCodegen && spec.soa && !attributes.empty()) {
+        const std::string& name = spec.name;
+        const std::string& first = attributes.front().first;
+        std::string members, reserve, copy, move, get;
+        for (const auto& [member, type] : attributes) {
+            TypeLayout layout;
+            typeLayout(type, layout);
+            members += "    std::vector<" + type + "> " + member + ";\n";
+            reserve += "        " + member + ".reserve(count);\n";
+            copy += "        " + member + ".push_back(value." + member + ");\n";
+            move += "        " + member + ".push_back(" +
+                    (layout.cheap ? "value." + member : "std::move(value." + member + ")") + ");\n";
+            get += (get.empty() ? "" : ", ") + member + "[index]";
+        }
+        code += "\n// " + name + " as a structure of arrays: a loop over one member only touches that member's array\n";
+        code += "struct " + name + "SoA {\n" + members + "\n";
+        code += "    std::size_t size() const noexcept { return " + first + ".size(); }\n";
+        code += "    void reserve(std::size_t count) {\n" + reserve + "    }\n";
+        if (moveOnly.empty()) {
+            code += "    void push_back(const " + name + "& value) {\n" + copy + "    }\n";
+        }
+        code += "    void push_back(" + name + "&& value) {\n" + move + "    }\n";
+        if (moveOnly.empty()) {
+            code += "    " + name + " get(std::size_t index) const { return " + name + "(" + get + "); }\n";
+        } else {
+            std::cout << name << "SoA: " << moveOnly << " cannot be copied, so elements are only moved in and there is "
+                      << "no get(); use the arrays directly" << std::endl;
+        }
+        code += "};\n";
+    }
+
     return code;
-}
\ No newline at end of file
+}
@@ -2,40 +2,185 @@
 #ifndef PROJECTMANAGER_H
 #define PROJECTMANAGER_H
 
+#include <filesystem>
+#include <map>
+#include <set>
 #include <string>
 #include <vector>
+#include "IncludeGraph.h"
+#include "SourceIndex.h"
+#include "TestRunner.h"
+
+struct BuildOptions {
+    unsigned jobs = 0; // 0 means use all hardware threads
+    bool explain = false;
+    bool unity = false;
+    unsigned unityBatchSize = 8;
+    std::vector<std::string> unityExclude; // module names or paths under src/ kept out of the batches
+    std::string buildDir = "build";   // relative to the project
+    std::vector<std::string> configs; // profiles built side by side in build-<profile>
+    std::string profile;              // debug, release, release-lto, pgo or asan; the tree's last one when empty
+    std::string march;                // -march value; native for release-lto and pgo when empty
+    std::string trainCommand;         // pgo training workload; the benchmarks, else the tests, when empty
+    bool farm = false;                // compile and link on our own scheduler instead of the build tool's
+    bool prepared = false;            // project files and Conan already set up by the parent `build --configs`
+};
+
+struct TestOptions {
+    unsigned jobs = 0; // 0 means use all hardware threads
+    std::string junitPath; // defaults to build/test-results.xml
+    std::vector<std::string> names; // CTest names to run, all when empty
+    bool changedOnly = false;
+    std::string changedSince = "HEAD"; // git ref compared against with --changed
+    std::string profile;  // runs the tests of build-<profile>
+    std::string buildDir; // relative to the project; overrides the one --profile picks
+};
+
+struct BenchOptions {
+    std::string filter;        // --benchmark_filter regex, all benchmarks when empty
+    unsigned repetitions = 10;
+    int cpu = -1;              // CPU to pin to, the last allowed one when negative
+    double threshold = 5;      // percent the median may grow before it counts as a regression
+    std::string baseline;      // git ref compared against, the saved baseline when empty
+    bool saveBaseline = false; // make this commit the baseline
+    std::string profile;       // builds and runs build-<profile> with that profile
+    std::string buildDir;      // relative to the project; overrides the one --profile picks
+};
+
+struct SourceOptions {
+    std::vector<std::string> extensions; // e.g. "cpp" or ".h"; all C++ files when empty
+    std::string module;                  // only files of this module
+    std::string changedSince;            // git ref; only files changed since it when set
+};
+
+// Code generated by `src` and `init --from`; parameters and attributes are (name, type) pairs
+struct FunctionSpec {
+    std::string name;
+    std::string description;
+    std::string returnType = "void";
+    std::vector<std::pair<std::string, std::string>> parameters;
+};
+
+struct ClassSpec {
+    std::string type = "class"; // or "struct"
+    std::string name;
+    std::string description;
+    std::vector<std::pair<std::string, std::string>> attributes;
+    std::vector<FunctionSpec> methods;
+    bool soa = false; // with performance codegen, also a structure-of-arrays container <name>SoA
+};
 
 class ProjectManager {
 public:
     ProjectManager(const std::string& projectName);
 
     void initializeProject();
-    void addDependency(const std::string& dependency);
-    void buildProject();
-    void runTests();
+    bool initializeFromSpec(const std::string& specPath);
+    bool addDependencies(const std::vector<std::string>& packages);
+    bool buildProject(const BuildOptions& options = BuildOptions());
+    int runTests(const TestOptions& options = TestOptions());
+    int runBenchmarks(const BenchOptions& options = BenchOptions());
+    void watchProject(const BuildOptions& options, unsigned debounceMs = 150);
 
     void createHeader(const std::string& headerName);
-    void createModule(const std::string& moduleName, bool createHeader = false);
+    void createModule(const std::string& moduleName, bool createHeader = false, bool cxxModule = false);
+    // Turns headers under include/ (all when empty) into C++20 named modules in src/
+    bool migrateToModules(const std::vector<std::string>& headers);
+    bool createBenchmark(const std::string& benchName);
     void deleteModule(const std::string& moduleName);
     void srcCommand(const std::string& subCommand = "");
+    // Project-relative paths of the files under src/, include/, test/ and bench/ that match
+    bool listSourceFiles(const SourceOptions& options = SourceOptions());
+    // Prints "path:line: text" for every line of a matching file that contains text
+    bool grepSourceFiles(const std::string& text, const SourceOptions& options = SourceOptions());
+    bool cacheCommand(const std::string& subCommand, const std::string& argument = "");
+    bool analyzePrecompiledHeader(unsigned threshold = 0);
+    bool analyzeRebuildCost(size_t top = 20, bool measure = false);
+    bool collectGarbage(const std::string& maxAge = "30d");
+    // limit is the number of headers fanout lists
+    bool depsCommand(const std::string& query, const std::string& argument = "", size_t limit = 20);
+    // Loads the include index into memory and keeps it there, for the daemon's request children
+    void warmResidentState();
 
 private:
     std::string projectName;
     std::vector<std::string> dependencies;
+    std::string pgoPhase; // "generate" or "use" while the pgo profile builds
+    bool performanceCodegen = false; // `src --perf` or "codegen": "performance" in an init spec
 
     void createDirectory(const std::string& path);
     void createFile(const std::string& path, const std::string& content);
-    void executeCommand(const std::string& command);
-    void executeCommandWithOutput(const std::string& command); // New method
+    void writeFiles(const std::map<std::string, std::string>& files);
+    int executeCommand(const std::vector<std::string>& argv, const std::string& workingDirectory = "");
+    std::string captureCommandOutput(const std::vector<std::string>& argv, const std::string& workingDirectory = "");
     void deleteFile(const std::string& path);
 
+    bool commandExists(const std::string& program);
+    std::string conanProgram();
+    std::string conanHome();
+    std::string conanProfilePath();
+    int runConan(const std::vector<std::string>& args);
+    std::map<std::string, std::string> dependencyInputs(const std::string& buildDir, const std::string& buildType);
+    bool installDependencies(const std::string& buildDir, const std::string& buildType = "Release", bool explain = false);
+    std::map<std::string, std::string> cacheEntries(const std::string& buildDir);
+    std::string cachedGenerator(const std::string& buildDir);
+    std::map<std::string, std::string> configureInputs(const std::string& buildDir, const std::string& generator,
+                                                       const std::vector<std::string>& definitions);
+    std::vector<std::string> staleConfigureInputs(const std::string& buildDir,
+                                                  const std::map<std::string, std::string>& inputs);
+    void writeConfigureManifest(const std::string& buildDir, const std::map<std::string, std::string>& inputs);
+    void refreshGeneratorStamps(const std::string& buildDir, const std::string& generator);
+    void writeUnityBatches(const std::string& buildDir, const BuildOptions& options);
+    std::pair<std::string, std::string> buildProfile(const std::string& buildDir, const BuildOptions& options);
+    bool hasBuildProfiles();
+    bool wireBuildProfiles();
+    bool buildWithProfileGuidance(const BuildOptions& options);
+    bool buildConfigurations(const BuildOptions& options);
+    bool buildWithFarm(const std::string& buildDir, unsigned jobs);
+    bool runTrainingWorkload(const BuildOptions& options, const std::string& buildDir);
+    void updateTargetGraph();
+    bool usesCxxModules();
+    IncludeGraph includeGraph();
+    std::map<std::string, double> translationUnitTimes(const IncludeGraph& graph, bool measure, std::string& origin);
+
+    std::vector<TestCase> listTests(const std::string& buildDir);
+    std::vector<std::string> changedFiles(const std::string& ref);
+    std::map<std::string, std::set<std::string>> targetSourceDependencies(const std::string& buildDir);
+    std::map<std::string, std::set<std::string>> targetLinkDependencies(const std::string& buildDir);
+    bool selectAffectedTests(const std::string& buildDir, const std::string& ref, std::vector<std::string>& names);
+
+    std::string projectTargetName();
+    std::string cxxCompiler(const std::string& buildDir); // the one buildDir was configured with, else $CXX
+    std::string cxxStandardFlag();
+    void wirePrecompiledHeader();
+    void wireBenchmarks();
+    void wireDependencies(const std::string& buildDir); // names from the CMakeDeps files in buildDir
+    std::vector<std::string> benchmarkExecutables(const std::string& buildDir);
+    std::string commitId();
+
+    std::string compilerCacheProgram();
+    std::pair<long, long> compilerCacheCounters(const std::string& program);
+    void reportNinjaPhases(const std::string& buildDir, std::filesystem::file_time_type buildStart);
+
     void setupPythonVirtualEnv();
     bool promptToInstallPackageManager();
 
-    void listSourceFiles();
+    std::vector<SourceFile> sourceFiles(SourceIndex& index, const SourceOptions& options);
     void editSourceFile(const std::string& fileName);
     std::string createClassOrStructPrompt(const std::string& type, const std::string& name);
     std::string createFunctionPrompt(const std::string &name, bool nested = false);
+    FunctionSpec promptFunction(const std::string& name);
+
+    std::map<std::string, std::string> projectFiles(const std::string& conanfileContent);
+    std::string mainSource();
+    std::string headerSource(const std::string& headerName);
+    std::string moduleSource(const std::string& moduleName, bool withHeader);
+    std::string moduleInterfaceSource(const std::string& moduleName);
+    std::string benchSource(const std::string& benchName);
+    // members: the attributes of the class a method belongs to
+    std::string generateFunction(const FunctionSpec& function, bool nested = false,
+                                 const std::vector<std::pair<std::string, std::string>>& members = {});
+    std::string generateClassOrStruct(const ClassSpec& spec);
 };
 
 #endif // PROJECTMANAGER_H
\ No newline at end of file
@@ -0,0 +1,287 @@
+// src/SourceIndex.cpp
+#include "SourceIndex.h"
+#include "FileBatch.h"
+#include "IncludeGraph.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <dirent.h>
+#include <sys/stat.h>
+
+static const char* const kSnapshotHeader = "cpp-manager source snapshot 1";
+static const char* const kTrigramHeader = "cpp-manager trigram index 1\n";
+
+static int64_t mtimeOf(const struct stat& info) {
+    return static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+}
+
+// Every distinct 3-byte sequence of content, sorted; seen is a 2^24-bit scratch set left all zero
+static std::vector<uint32_t> trigramsOf(const std::string& content, std::vector<uint64_t>& seen) {
+    std::vector<uint32_t> result;
+    for (size_t i = 0; i + 2 < content.size(); ++i) {
+        uint32_t trigram = static_cast<uint32_t>(static_cast<unsigned char>(content[i])) << 16 |
+                           static_cast<uint32_t>(static_cast<unsigned char>(content[i + 1])) << 8 |
+                           static_cast<unsigned char>(content[i + 2]);
+        uint64_t bit = 1ULL << (trigram & 63);
+        if (!(seen[trigram >> 6] & bit)) {
+            seen[trigram >> 6] |= bit;
+            result.push_back(trigram);
+        }
+    }
+    for (uint32_t trigram : result) {
+        seen[trigram >> 6] = 0;
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+SourceIndex::SourceIndex(const std::string& projectDir) : projectDir(projectDir) {}
+
+void SourceIndex::update(const std::string& snapshotPath, bool withStat) {
+    // Snapshot: "D <mtime> <dir>" per directory, followed by "f <name>" or "d <name>" per entry
+    struct Directory {
+        int64_t mtimeNs = 0;
+        std::vector<std::pair<std::string, bool>> entries; // name, is a directory
+    };
+    std::unordered_map<std::string, Directory> previous;
+    {
+        std::ifstream in(snapshotPath);
+        std::string line;
+        Directory* directory = nullptr;
+        if (std::getline(in, line) && line == kSnapshotHeader) {
+            while (std::getline(in, line)) {
+                if (line.size() > 2 && line[0] == 'D') {
+                    char* end;
+                    int64_t mtime = std::strtoll(line.c_str() + 2, &end, 10);
+                    directory = &previous[*end ? end + 1 : ""];
+                    directory->mtimeNs = mtime;
+                } else if (line.size() > 2 && directory) {
+                    directory->entries.push_back({line.substr(2), line[0] == 'd'});
+                }
+            }
+        }
+    }
+
+    // Returns false when dir is not a directory; previous is only read, so workers share it
+    std::atomic<size_t> reread{0};
+    auto read = [&](const std::string& dir, Directory& directory, std::vector<SourceFile>& files,
+                    std::vector<std::string>& subdirectories) {
+        std::string path = projectDir + "/" + dir;
+        struct stat info;
+        if (stat(path.c_str(), &info) != 0 || !S_ISDIR(info.st_mode)) {
+            return false;
+        }
+        directory.mtimeNs = mtimeOf(info);
+        auto known = previous.find(dir);
+        if (known != previous.end() && known->second.mtimeNs == directory.mtimeNs) {
+            directory.entries = known->second.entries;
+        } else if (DIR* handle = opendir(path.c_str())) {
+            ++reread;
+            while (dirent* entry = readdir(handle)) {
+                std::string name = entry->d_name;
+                if (name[0] == '.') {
+                    continue;
+                }
+                bool isDirectory = entry->d_type == DT_DIR;
+                if (entry->d_type == DT_UNKNOWN || entry->d_type == DT_LNK) {
+                    struct stat target;
+                    isDirectory = fstatat(dirfd(handle), entry->d_name, &target, 0) == 0 && S_ISDIR(target.st_mode);
+                }
+                if (isDirectory || IncludeGraph::isIndexed(name)) {
+                    directory.entries.push_back({name, isDirectory});
+                }
+            }
+            closedir(handle);
+        }
+        for (const auto& [name, isDirectory] : directory.entries) {
+            if (isDirectory) {
+                subdirectories.push_back(dir + "/" + name);
+                continue;
+            }
+            SourceFile file;
+            file.path = dir + "/" + name;
+            struct stat fileInfo;
+            if (withStat) {
+                if (stat((projectDir + "/" + file.path).c_str(), &fileInfo) != 0) {
+                    continue;
+                }
+                file.mtimeNs = mtimeOf(fileInfo);
+                file.size = static_cast<uint64_t>(fileInfo.st_size);
+            }
+            files.push_back(file);
+        }
+        return true;
+    };
+
+    // Workers take directories from one stack and push the subdirectories they find; the walk is
+    // over when the stack is empty and no worker is reading
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::vector<std::string> pending = {"bench", "test", "include", "src"};
+    size_t active = 0;
+    std::map<std::string, Directory> current;
+    sourceFiles.clear();
+    auto worker = [&]() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait(lock, [&] { return !pending.empty() || active == 0; });
+            if (pending.empty()) {
+                return;
+            }
+            std::string dir = pending.back();
+            pending.pop_back();
+            ++active;
+            lock.unlock();
+
+            Directory directory;
+            std::vector<SourceFile> files;
+            std::vector<std::string> subdirectories;
+            bool found = read(dir, directory, files, subdirectories);
+
+            lock.lock();
+            if (found) {
+                current[dir] = std::move(directory);
+                sourceFiles.insert(sourceFiles.end(), files.begin(), files.end());
+                pending.insert(pending.end(), subdirectories.begin(), subdirectories.end());
+            }
+            --active;
+            wake.notify_all();
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < std::max(1u, std::thread::hardware_concurrency()); ++t) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : pool) {
+        thread.join();
+    }
+    std::sort(sourceFiles.begin(), sourceFiles.end(),
+              [](const SourceFile& a, const SourceFile& b) { return a.path < b.path; });
+    readCount = reread;
+
+    if (readCount == 0 && current.size() == previous.size()) {
+        return;
+    }
+    std::ostringstream out;
+    out << kSnapshotHeader << "\n";
+    for (const auto& [dir, directory] : current) {
+        out << "D " << directory.mtimeNs << " " << dir << "\n";
+        for (const auto& [name, isDirectory] : directory.entries) {
+            out << (isDirectory ? "d " : "f ") << name << "\n";
+        }
+    }
+    FileBatch batch;
+    batch.write(snapshotPath, out.str());
+    batch.commit();
+}
+
+void SourceIndex::updateTrigrams(const std::string& indexPath) {
+    // Per file: path, NUL, then mtime (int64), size (uint64), trigram count (uint32) and the trigrams
+    struct Indexed {
+        int64_t mtimeNs = 0;
+        uint64_t size = 0;
+        std::vector<uint32_t> trigrams;
+    };
+    std::unordered_map<std::string, Indexed> previous;
+    {
+        std::ifstream in(indexPath, std::ios::binary);
+        std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        size_t header = std::strlen(kTrigramHeader);
+        for (size_t pos = content.compare(0, header, kTrigramHeader) == 0 ? header : content.size();
+             pos < content.size();) {
+            size_t end = content.find('\0', pos);
+            if (end == std::string::npos || content.size() - end - 1 < 20) {
+                break;
+            }
+            Indexed indexed;
+            uint32_t count = 0;
+            std::memcpy(&indexed.mtimeNs, &content[end + 1], 8);
+            std::memcpy(&indexed.size, &content[end + 9], 8);
+            std::memcpy(&count, &content[end + 17], 4);
+            if (content.size() - end - 21 < static_cast<size_t>(count) * 4) {
+                break;
+            }
+            indexed.trigrams.resize(count);
+            std::memcpy(indexed.trigrams.data(), &content[end + 21], static_cast<size_t>(count) * 4);
+            previous.emplace(content.substr(pos, end - pos), std::move(indexed));
+            pos = end + 21 + static_cast<size_t>(count) * 4;
+        }
+    }
+
+    std::vector<size_t> stale;
+    trigrams.assign(sourceFiles.size(), {});
+    for (size_t i = 0; i < sourceFiles.size(); ++i) {
+        auto known = previous.find(sourceFiles[i].path);
+        if (known != previous.end() && known->second.mtimeNs == sourceFiles[i].mtimeNs &&
+            known->second.size == sourceFiles[i].size) {
+            trigrams[i] = std::move(known->second.trigrams);
+        } else {
+            stale.push_back(i);
+        }
+    }
+
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        std::vector<uint64_t> seen(1 << 18);
+        for (size_t n = next++; n < stale.size(); n = next++) {
+            size_t i = stale[n];
+            std::ifstream in(projectDir + "/" + sourceFiles[i].path, std::ios::binary);
+            std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            trigrams[i] = trigramsOf(content, seen);
+        }
+    };
+    unsigned threads = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), stale.size() / 16 + 1);
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : pool) {
+        thread.join();
+    }
+    reindexedCount = stale.size();
+
+    if (stale.empty() && previous.size() == sourceFiles.size()) {
+        return;
+    }
+    std::string out = kTrigramHeader;
+    for (size_t i = 0; i < sourceFiles.size(); ++i) {
+        uint32_t count = static_cast<uint32_t>(trigrams[i].size());
+        out += sourceFiles[i].path;
+        out += '\0';
+        out.append(reinterpret_cast<const char*>(&sourceFiles[i].mtimeNs), 8);
+        out.append(reinterpret_cast<const char*>(&sourceFiles[i].size), 8);
+        out.append(reinterpret_cast<const char*>(&count), 4);
+        out.append(reinterpret_cast<const char*>(trigrams[i].data()), static_cast<size_t>(count) * 4);
+    }
+    FileBatch batch;
+    batch.write(indexPath, out);
+    batch.commit();
+}
+
+std::vector<size_t> SourceIndex::candidates(const std::string& text) const {
+    std::vector<uint64_t> seen(1 << 18);
+    std::vector<uint32_t> wanted = trigramsOf(text, seen);
+    std::vector<size_t> result;
+    for (size_t i = 0; i < sourceFiles.size(); ++i) {
+        // Files without a trigram set (updateTrigrams not run) are always candidates
+        bool all = true;
+        for (size_t k = 0; all && i < trigrams.size() && k < wanted.size(); ++k) {
+            all = std::binary_search(trigrams[i].begin(), trigrams[i].end(), wanted[k]);
+        }
+        if (all) {
+            result.push_back(i);
+        }
+    }
+    return result;
+}
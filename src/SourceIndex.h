@@ -0,0 +1,45 @@
+// src/SourceIndex.h
+#ifndef SOURCEINDEX_H
+#define SOURCEINDEX_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct SourceFile {
+    std::string path;   // project-relative
+    int64_t mtimeNs = 0; // 0 unless the walk stat'ed files
+    uint64_t size = 0;
+};
+
+// The C++ files under src/, include/, test/ and bench/, for `src --list` and `src --grep`.
+// Directories are walked in parallel, and one whose mtime matches the snapshot of the last
+// walk is not read again: its entries can only change when the directory's mtime does.
+// The trigram sets of the files are kept in a second cache, so a search only opens the
+// files that contain every trigram of the text.
+class SourceIndex {
+public:
+    explicit SourceIndex(const std::string& projectDir);
+
+    // withStat also stats every file, for the trigram cache
+    void update(const std::string& snapshotPath, bool withStat);
+    // Re-reads files whose mtime or size changed since the cache was written; needs update(.., true)
+    void updateTrigrams(const std::string& indexPath);
+
+    // Sorted by path
+    const std::vector<SourceFile>& files() const { return sourceFiles; }
+    // Indices into files() of those that may contain text; all of them for text under three bytes
+    std::vector<size_t> candidates(const std::string& text) const;
+
+    size_t directoriesRead() const { return readCount; }
+    size_t filesReindexed() const { return reindexedCount; }
+
+private:
+    std::string projectDir;
+    std::vector<SourceFile> sourceFiles;
+    std::vector<std::vector<uint32_t>> trigrams; // sorted, per file
+    size_t readCount = 0;
+    size_t reindexedCount = 0;
+};
+
+#endif // SOURCEINDEX_H
@@ -0,0 +1,211 @@
+// src/TargetGraph.cpp
+#include "TargetGraph.h"
+#include "IncludeGraph.h"
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <functional>
+
+namespace fs = std::filesystem;
+
+static const char* const kBeginMarker = "# BEGIN cpp-manager targets";
+static const char* const kEndMarker = "# END cpp-manager targets";
+
+std::string TargetGraph::moduleOf(const std::string& path) {
+    fs::path relative(path);
+    auto part = relative.begin();
+    if (part == relative.end() || (*part != "src" && *part != "include") || ++part == relative.end()) {
+        return "";
+    }
+    fs::path first = *part;
+    if (++part != relative.end()) {
+        return first.string();
+    }
+    return first.stem() == "main" ? "" : first.stem().string();
+}
+
+TargetGraph TargetGraph::scan(const std::map<std::string, std::string>& files) {
+    auto exists = [&](const std::string& path) { return files.count(path) != 0; };
+    std::map<std::string, std::set<std::string>> includes;
+    for (const auto& [path, content] : files) {
+        auto& targets = includes[path];
+        for (const auto& directive : IncludeGraph::parse(content.data(), content.size())) {
+            std::string target = IncludeGraph::resolve(path, directive, exists);
+            if (!target.empty()) {
+                targets.insert(target);
+            }
+        }
+    }
+    return fromIncludes(includes);
+}
+
+TargetGraph TargetGraph::fromIncludeGraph(const IncludeGraph& graph) {
+    std::map<std::string, std::set<std::string>> includes;
+    for (const auto& path : graph.files()) {
+        includes[path] = graph.includes(path);
+    }
+    return fromIncludes(includes);
+}
+
+TargetGraph TargetGraph::fromIncludes(const std::map<std::string, std::set<std::string>>& includes) {
+    TargetGraph graph;
+    for (const auto& [path, targets] : includes) {
+        if (!IncludeGraph::isSource(path) || *fs::path(path).begin() != "src") {
+            continue;
+        }
+        std::string module = moduleOf(path);
+        (module.empty() ? graph.executableSources : graph.moduleSources[module]).push_back(path);
+    }
+
+    // Only modules with sources become libraries; headers of anything else do not add edges
+    for (const auto& [path, targets] : includes) {
+        std::string from = moduleOf(path);
+        if (!graph.moduleSources.count(from)) {
+            continue;
+        }
+        for (const auto& target : targets) {
+            std::string to = moduleOf(target);
+            if (to != from && graph.moduleSources.count(to)) {
+                graph.edges[from].insert(to);
+            }
+        }
+    }
+
+    // Depth-first in name order: an edge back to a module still on the stack closes a cycle, which
+    // CMake rejects between object libraries, so it is dropped. Post-order puts dependencies first.
+    std::map<std::string, int> state; // 0 unvisited, 1 on the stack, 2 done
+    std::function<void(const std::string&)> visit = [&](const std::string& module) {
+        state[module] = 1;
+        auto& targets = graph.edges[module];
+        for (auto it = targets.begin(); it != targets.end();) {
+            if (state[*it] == 1) {
+                graph.dropped.push_back({module, *it});
+                it = targets.erase(it);
+                continue;
+            }
+            if (state[*it] == 0) {
+                visit(*it);
+            }
+            ++it;
+        }
+        state[module] = 2;
+        graph.order.push_back(module);
+    };
+    for (const auto& [module, sources] : graph.moduleSources) {
+        if (state[module] == 0) {
+            visit(module);
+        }
+    }
+    return graph;
+}
+
+std::string TargetGraph::cmakeBlock(const std::string& executable) const {
+    auto targetName = [&](const std::string& module) {
+        std::string name = executable + "_" + module;
+        for (char& c : name) {
+            if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_' && c != '-') {
+                c = '_';
+            }
+        }
+        return name;
+    };
+
+    // C++20 interface units go into a CXX_MODULES file set, which CMake scans to order the compiles
+    auto isInterface = [](const std::string& source) { return fs::path(source).extension() == ".cppm"; };
+    auto interfaceSources = [&](const std::string& target, const std::vector<std::string>& sources,
+                                const std::string& scope) {
+        std::string lines;
+        if (std::any_of(sources.begin(), sources.end(), isInterface)) {
+            lines += "    target_sources(" + target + " " + scope + " FILE_SET CXX_MODULES FILES";
+            for (const auto& source : sources) {
+                if (isInterface(source)) {
+                    lines += "\n        " + source;
+                }
+            }
+            lines += ")\n    target_compile_features(" + target + " " + scope + " cxx_std_20)\n";
+            // A module unit has to come first in its translation unit, before any forced #include
+            lines += "    set_source_files_properties(";
+            for (const auto& source : sources) {
+                lines += source + (&source == &sources.back() ? "" : " ");
+            }
+            lines += " PROPERTIES SKIP_PRECOMPILE_HEADERS ON)\n";
+        }
+        return lines;
+    };
+    bool cxxModules = std::any_of(executableSources.begin(), executableSources.end(), isInterface);
+    for (const auto& [module, sources] : moduleSources) {
+        cxxModules = cxxModules || std::any_of(sources.begin(), sources.end(), isInterface);
+    }
+
+    std::string block = std::string(kBeginMarker) + R"(
+# Generated from the #include graph by `cpp-manager create module`, `delete module` and `build`.
+# Changes between the markers are overwritten.
+)";
+    if (cxxModules) {
+        block += R"(if(CMAKE_VERSION VERSION_LESS 3.28)
+    message(FATAL_ERROR "The C++20 module units (.cppm) under src/ need CMake 3.28 or newer")
+endif()
+set(CMAKE_CXX_SCAN_FOR_MODULES ON)
+)";
+    }
+    block += R"(if(EXISTS "${CMAKE_BINARY_DIR}/unity/sources.cmake")
+    # `cpp-manager build --unity`: one target compiled from the unity batches
+    include("${CMAKE_BINARY_DIR}/unity/sources.cmake")
+    add_executable()" + executable + R"( ${CPP_MANAGER_SOURCES})
+)";
+    if (cxxModules) {
+        block += "    target_sources(" + executable + " PRIVATE FILE_SET CXX_MODULES FILES ${CPP_MANAGER_MODULE_UNITS})\n";
+        block += "    target_compile_features(" + executable + " PRIVATE cxx_std_20)\n";
+    }
+    block += R"(    set(CPP_MANAGER_MODULES)
+else()
+)";
+    std::string modules;
+    for (const auto& module : order) {
+        const auto& sources = moduleSources.at(module);
+        block += "    add_library(" + targetName(module) + " OBJECT";
+        for (const auto& source : sources) {
+            if (!isInterface(source)) {
+                block += "\n        " + source;
+            }
+        }
+        block += ")\n";
+        block += interfaceSources(targetName(module), sources, "PUBLIC");
+        auto dependencies = edges.find(module);
+        if (dependencies != edges.end() && !dependencies->second.empty()) {
+            block += "    target_link_libraries(" + targetName(module) + " PUBLIC";
+            for (const auto& dependency : dependencies->second) {
+                block += " " + targetName(dependency);
+            }
+            block += ")\n";
+        }
+        modules += " " + targetName(module);
+    }
+    block += "    set(CPP_MANAGER_MODULES" + modules + ")\n";
+    block += "    add_executable(" + executable;
+    for (const auto& source : executableSources) {
+        if (!isInterface(source)) {
+            block += " " + source;
+        }
+    }
+    block += ")\n";
+    block += interfaceSources(executable, executableSources, "PRIVATE");
+    block += "    target_link_libraries(" + executable + " PRIVATE ${CPP_MANAGER_MODULES})\n";
+    block += "endif()\n" + std::string(kEndMarker) + "\n";
+    return block;
+}
+
+bool TargetGraph::splice(std::string& cmakeLists, const std::string& block) {
+    size_t begin = cmakeLists.find(kBeginMarker);
+    size_t end = cmakeLists.find(kEndMarker);
+    if (begin == std::string::npos || end == std::string::npos || end < begin) {
+        return false;
+    }
+    end = cmakeLists.find('\n', end);
+    cmakeLists.replace(begin, end == std::string::npos ? std::string::npos : end + 1 - begin, block);
+    return true;
+}
+
+bool TargetGraph::hasBlock(const std::string& cmakeLists) {
+    return cmakeLists.find(kBeginMarker) != std::string::npos;
+}
@@ -0,0 +1,48 @@
+// src/TargetGraph.h
+#ifndef TARGETGRAPH_H
+#define TARGETGRAPH_H
+
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+class IncludeGraph;
+
+// Splits a project into one CMake OBJECT library per module and links them along the
+// project's own #include "..." and import edges. A module is a directory directly under src/
+// (or include/), or a top-level src/<name>.cpp with its include/<name>.h or its C++20
+// interface unit src/<name>.cppm. src/main.cpp belongs to the executable, which links every
+// module.
+class TargetGraph {
+public:
+    // files maps project-relative paths under src/ and include/ to their content
+    static TargetGraph scan(const std::map<std::string, std::string>& files);
+    static TargetGraph fromIncludeGraph(const IncludeGraph& graph);
+
+    // The generated part of CMakeLists.txt, including the marker lines
+    std::string cmakeBlock(const std::string& executable) const;
+    // Replaces the marker block in cmakeLists; false when it has none
+    static bool splice(std::string& cmakeLists, const std::string& block);
+    static bool hasBlock(const std::string& cmakeLists);
+    // "src/net/socket.cpp" -> "net", "include/user.h" -> "user", "src/main.cpp" and files
+    // outside src/ and include/ -> ""
+    static std::string moduleOf(const std::string& path);
+
+    const std::map<std::string, std::vector<std::string>>& modules() const { return moduleSources; }
+    // Edges removed to keep the graph acyclic, as (from, to)
+    const std::vector<std::pair<std::string, std::string>>& droppedEdges() const { return dropped; }
+
+private:
+    // Project-relative file -> project files it includes
+    static TargetGraph fromIncludes(const std::map<std::string, std::set<std::string>>& includes);
+
+    std::map<std::string, std::vector<std::string>> moduleSources;
+    std::vector<std::string> executableSources;
+    std::map<std::string, std::set<std::string>> edges;
+    std::vector<std::string> order; // dependencies before their dependents
+    std::vector<std::pair<std::string, std::string>> dropped;
+};
+
+#endif // TARGETGRAPH_H
@@ -0,0 +1,302 @@
+// src/TestRunner.cpp
+#include "TestRunner.h"
+#include "Process.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string_view>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+static const char* const kDurationsFile = "/.cpp-manager/test-durations";
+
+// Runs argv in dir and returns its exit code, stdout and stderr combined in output
+static int capture(const std::vector<std::string>& argv, const std::string& dir,
+                   const std::map<std::string, std::string>& environment, std::string& output) {
+    ProcessSpec spec;
+    spec.argv = argv;
+    spec.workingDirectory = dir;
+    spec.environment = environment;
+    spec.stdoutMode = ProcessOutput::Capture;
+    spec.stderrMode = ProcessOutput::MergeIntoStdout;
+    ProcessResult result = Process::run(spec);
+    output = result.out;
+    return result.exitCode;
+}
+
+// Which of needles occur in the file; it is mapped once instead of copied, test binaries can be large
+static std::vector<bool> fileContains(const std::string& path, const std::vector<std::string>& needles) {
+    std::vector<bool> found(needles.size(), false);
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return found;
+    }
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        size_t size = static_cast<size_t>(info.st_size);
+        void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            std::string_view content(static_cast<const char*>(data), size);
+            for (size_t i = 0; i < needles.size(); ++i) {
+                found[i] = content.find(needles[i]) != std::string_view::npos;
+            }
+            munmap(data, size);
+        }
+    }
+    close(fd);
+    return found;
+}
+
+static std::string xmlEscape(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+        switch (c) {
+            case '&': escaped += "&amp;"; break;
+            case '<': escaped += "&lt;"; break;
+            case '>': escaped += "&gt;"; break;
+            case '"': escaped += "&quot;"; break;
+            default:
+                // Control characters other than tab and newlines are not allowed in XML 1.0
+                if (static_cast<unsigned char>(c) >= 0x20 || c == '\t' || c == '\n' || c == '\r') {
+                    escaped += c;
+                }
+        }
+    }
+    return escaped;
+}
+
+TestRunner::TestRunner(const std::string& buildDir, unsigned jobs)
+    : buildDir(buildDir), jobs(jobs ? jobs : std::max(1u, std::thread::hardware_concurrency())) {}
+
+std::vector<std::string> TestRunner::listCommand(const std::string& exe) {
+    auto found = fileContains(exe, {"gtest_list_tests", "list-test-names-only", "Catch::", "list-tests"});
+    if (found[0]) {
+        return {exe, "--gtest_list_tests"};
+    }
+    if (found[1]) {
+        return {exe, "--list-test-names-only"};
+    }
+    if (found[2] && found[3]) {
+        return {exe, "--list-tests", "--verbosity", "quiet"};
+    }
+    return {};
+}
+
+std::vector<TestRunner::TestUnit> TestRunner::shard(const TestCase& test) {
+    TestUnit whole;
+    whole.suite = test.name;
+    whole.name = test.name;
+    whole.command = test.command;
+    whole.workingDirectory = test.workingDirectory;
+    whole.environment = test.environment;
+    whole.willFail = test.willFail;
+    whole.timeoutSeconds = test.timeoutSeconds;
+
+    // Tests registered with arguments (gtest_discover_tests, custom filters) are already split. A WILL_FAIL
+    // binary usually fails on purpose in one case, so its cases that pass must not count on their own.
+    if (test.command.size() != 1 || test.willFail) {
+        return {whole};
+    }
+    const std::string& exe = test.command[0];
+
+    std::vector<std::string> list = listCommand(exe);
+    if (list.empty()) {
+        return {whole};
+    }
+    bool gtest = list[1] == "--gtest_list_tests";
+
+    std::string listing;
+    if (capture(list, test.workingDirectory, test.environment, listing) != 0) {
+        return {whole};
+    }
+
+    std::vector<TestUnit> units;
+    std::istringstream lines(listing);
+    std::string line, suite;
+    while (std::getline(lines, line)) {
+        if (gtest) {
+            // "Suite." followed by indented "  Case", either optionally followed by "  # GetParam() = ..."
+            std::string name = line.substr(0, line.find("  #"));
+            name.erase(name.find_last_not_of(" \r") + 1);
+            if (name.empty()) {
+                continue;
+            }
+            if (name[0] != ' ') {
+                suite = name;
+                continue;
+            }
+            name = name.substr(name.find_first_not_of(' '));
+            if (suite.rfind("DISABLED_", 0) == 0 || name.rfind("DISABLED_", 0) == 0) {
+                continue;
+            }
+            TestUnit unit = whole;
+            unit.name = suite + name;
+            unit.command = {exe, "--gtest_filter=" + suite + name};
+            units.push_back(unit);
+        } else {
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            if (line.empty()) {
+                continue;
+            }
+            // Catch2 test specs treat these characters specially
+            std::string spec;
+            for (char c : line) {
+                if (std::string(",[]*\\\"").find(c) != std::string::npos) {
+                    spec += '\\';
+                }
+                spec += c;
+            }
+            TestUnit unit = whole;
+            unit.name = line;
+            unit.command = {exe, spec};
+            units.push_back(unit);
+        }
+    }
+    return units.empty() ? std::vector<TestUnit>{whole} : units;
+}
+
+int TestRunner::run(const std::vector<TestCase>& tests, const std::string& junitPath) {
+    durations = readDurations(buildDir + kDurationsFile);
+
+    std::vector<TestUnit> units;
+    for (const auto& test : tests) {
+        for (auto& unit : shard(test)) {
+            auto known = durations.find(unit.suite + "/" + unit.name);
+            // Unknown tests go first: they might be the long ones
+            unit.expectedSeconds = known != durations.end() ? known->second : std::numeric_limits<double>::max();
+            units.push_back(std::move(unit));
+        }
+    }
+
+    // Longest first, so the slowest cases do not end up alone at the tail of the run
+    std::stable_sort(units.begin(), units.end(), [](const TestUnit& a, const TestUnit& b) {
+        return a.expectedSeconds > b.expectedSeconds;
+    });
+
+    std::cout << "Running " << units.size() << " test cases from " << tests.size() << " tests on " << jobs
+              << " workers" << std::endl;
+
+    std::vector<ProcessSpec> specs;
+    for (const auto& unit : units) {
+        ProcessSpec spec;
+        spec.argv = unit.command;
+        spec.workingDirectory = unit.workingDirectory;
+        spec.environment = unit.environment;
+        spec.timeoutSeconds = unit.timeoutSeconds;
+        spec.stdoutMode = ProcessOutput::Capture;
+        spec.stderrMode = ProcessOutput::MergeIntoStdout;
+        specs.push_back(spec);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    size_t finished = 0;
+    Process::runAll(specs, jobs, [&](size_t index, const ProcessResult& result) {
+        TestUnit& unit = units[index];
+        unit.exitCode = result.exitCode;
+        unit.timedOut = result.timedOut;
+        unit.seconds = result.seconds;
+        unit.output = result.out + result.err;
+
+        std::cout << "[" << ++finished << "/" << units.size() << "] " << (unit.failed() ? "FAIL " : "PASS ")
+                  << unit.suite << (unit.name != unit.suite ? " :: " + unit.name : "") << " (" << std::fixed
+                  << std::setprecision(2) << unit.seconds << "s" << (unit.timedOut ? ", timed out" : "") << ")"
+                  << std::endl;
+        if (unit.failed()) {
+            std::cout << unit.output << std::endl;
+        }
+    });
+    double totalSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    saveDurations(units);
+    writeJUnit(junitPath, units, totalSeconds);
+
+    size_t failed = std::count_if(units.begin(), units.end(), [](const TestUnit& unit) { return unit.failed(); });
+    std::cout << units.size() - failed << "/" << units.size() << " test cases passed in " << std::fixed
+              << std::setprecision(2) << totalSeconds << "s. JUnit report: " << junitPath << std::endl;
+    return failed == 0 ? 0 : 1;
+}
+
+std::map<std::string, double> TestRunner::readDurations(const std::string& path) {
+    std::map<std::string, double> durations;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t tab = line.find('\t');
+        char* end = nullptr;
+        double seconds = std::strtod(line.c_str(), &end);
+        bool valid = tab != std::string::npos && tab > 0 && end == line.c_str() + tab;
+        if (valid && std::isfinite(seconds) && seconds >= 0) {
+            durations[line.substr(tab + 1)] = seconds;
+        }
+    }
+    return durations;
+}
+
+void TestRunner::writeDurations(const std::string& path, const std::map<std::string, double>& durations) {
+    fs::create_directories(fs::path(path).parent_path());
+    std::ofstream file(path);
+    for (const auto& [name, seconds] : durations) {
+        file << seconds << "\t" << name << "\n";
+    }
+}
+
+void TestRunner::saveDurations(const std::vector<TestUnit>& units) {
+    for (const auto& unit : units) {
+        durations[unit.suite + "/" + unit.name] = unit.seconds;
+    }
+    writeDurations(buildDir + kDurationsFile, durations);
+}
+
+void TestRunner::writeJUnit(const std::string& path, const std::vector<TestUnit>& units, double totalSeconds) {
+    std::map<std::string, std::vector<const TestUnit*>> suites;
+    for (const auto& unit : units) {
+        suites[unit.suite].push_back(&unit);
+    }
+
+    size_t failures = std::count_if(units.begin(), units.end(), [](const TestUnit& unit) { return unit.failed(); });
+    std::ofstream xml(path);
+    xml << std::fixed << std::setprecision(3);
+    xml << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+    xml << "<testsuites tests=\"" << units.size() << "\" failures=\"" << failures << "\" time=\"" << totalSeconds
+        << "\">\n";
+    for (const auto& [suite, cases] : suites) {
+        double suiteSeconds = 0;
+        size_t suiteFailures = 0;
+        for (const auto* unit : cases) {
+            suiteSeconds += unit->seconds;
+            suiteFailures += unit->failed();
+        }
+        xml << "  <testsuite name=\"" << xmlEscape(suite) << "\" tests=\"" << cases.size() << "\" failures=\""
+            << suiteFailures << "\" time=\"" << suiteSeconds << "\">\n";
+        for (const auto* unit : cases) {
+            xml << "    <testcase classname=\"" << xmlEscape(suite) << "\" name=\"" << xmlEscape(unit->name)
+                << "\" time=\"" << unit->seconds << "\"";
+            if (!unit->failed()) {
+                xml << "/>\n";
+                continue;
+            }
+            std::string message = unit->timedOut ? "timed out" : "exit code " + std::to_string(unit->exitCode);
+            if (unit->willFail && !unit->timedOut) {
+                message += ", expected to fail";
+            }
+            xml << ">\n      <failure message=\"" << message << "\">" << xmlEscape(unit->output)
+                << "</failure>\n    </testcase>\n";
+        }
+        xml << "  </testsuite>\n";
+    }
+    xml << "</testsuites>\n";
+}
@@ -0,0 +1,63 @@
+// src/TestRunner.h
+#ifndef TESTRUNNER_H
+#define TESTRUNNER_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+// One test as registered with CTest
+struct TestCase {
+    std::string name;
+    std::vector<std::string> command;
+    std::string workingDirectory;
+    std::map<std::string, std::string> environment; // ENVIRONMENT property
+    bool willFail = false;                          // WILL_FAIL: passes when it exits non-zero
+    double timeoutSeconds = 0;                      // TIMEOUT, 0 for none
+};
+
+// Runs CTest tests in parallel. GoogleTest and Catch2 executables are split into one
+// process per test case unless they are WILL_FAIL; everything else runs as a whole.
+class TestRunner {
+public:
+    TestRunner(const std::string& buildDir, unsigned jobs);
+
+    // Returns 0 when every test passed
+    int run(const std::vector<TestCase>& tests, const std::string& junitPath);
+
+    // The command that lists the test cases of a GoogleTest or Catch2 executable, recognized by
+    // strings in the binary; empty for anything else
+    static std::vector<std::string> listCommand(const std::string& exe);
+    // Seconds per "<suite>/<case>" as saved by writeDurations; unreadable lines are skipped
+    static std::map<std::string, double> readDurations(const std::string& path);
+    static void writeDurations(const std::string& path, const std::map<std::string, double>& durations);
+
+private:
+    struct TestUnit {
+        std::string suite;     // the CTest test it belongs to
+        std::string name;      // test case name, or the CTest name when not sharded
+        std::vector<std::string> command;
+        std::string workingDirectory;
+        std::map<std::string, std::string> environment;
+        bool willFail = false;
+        double timeoutSeconds = 0;
+        double expectedSeconds = 0;
+
+        int exitCode = 0;
+        bool timedOut = false;
+        double seconds = 0;
+        std::string output;
+
+        bool failed() const { return timedOut || (exitCode != 0) != willFail; }
+    };
+
+    std::string buildDir;
+    unsigned jobs;
+    std::map<std::string, double> durations;
+
+    std::vector<TestUnit> shard(const TestCase& test);
+    void saveDurations(const std::vector<TestUnit>& units);
+    void writeJUnit(const std::string& path, const std::vector<TestUnit>& units, double totalSeconds);
+};
+
+#endif // TESTRUNNER_H
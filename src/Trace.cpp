@@ -0,0 +1,220 @@
+// src/Trace.cpp
+#include "Trace.h"
+#include "Json.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+Trace& Trace::instance() {
+    static Trace trace;
+    return trace;
+}
+
+Trace::Trace() : start(std::chrono::steady_clock::now()), startWall(std::chrono::system_clock::now()) {}
+
+void Trace::enable(const std::string& outputPath) {
+    path = outputPath;
+}
+
+int64_t Trace::nowUs() const {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::string Trace::currentPhase() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::string joined;
+    for (const auto& phase : phases) {
+        joined += (joined.empty() ? "" : "/") + phase;
+    }
+    return joined;
+}
+
+void Trace::record(const TraceSpan& span) {
+    if (!enabled()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    spans.push_back(span);
+}
+
+Trace::Phase::Phase(const std::string& name) : startUs(Trace::instance().nowUs()) {
+    Trace& trace = Trace::instance();
+    std::lock_guard<std::mutex> lock(trace.mutex);
+    trace.phases.push_back(name);
+}
+
+Trace::Phase::~Phase() {
+    Trace& trace = Trace::instance();
+    TraceSpan span;
+    span.phase = trace.currentPhase();
+    span.name = span.phase;
+    span.process = "phases";
+    span.startUs = startUs;
+    span.endUs = trace.nowUs();
+    trace.record(span);
+
+    std::lock_guard<std::mutex> lock(trace.mutex);
+    trace.phases.pop_back();
+}
+
+void Trace::mergeNinjaLog(const std::string& buildDir, fs::file_time_type buildStart, int64_t buildStartUs) {
+    if (!enabled()) {
+        return;
+    }
+
+    std::string phase = currentPhase();
+    for (const auto& [output, times] : readNinjaLog(buildDir, buildStart)) {
+        TraceSpan span;
+        std::string extension = fs::path(output).extension().string();
+        bool isObject = extension == ".o" || extension == ".obj";
+        span.name = (isObject ? "compile " : "link ") + output;
+        span.phase = phase;
+        span.process = "ninja";
+        span.startUs = buildStartUs + times.first * 1000;
+        span.endUs = buildStartUs + times.second * 1000;
+        record(span);
+    }
+}
+
+void Trace::mergeTimeTraces(const std::string& buildDir, fs::file_time_type buildStart) {
+    if (!enabled()) {
+        return;
+    }
+
+    // Clang writes "<object without .o>.json" next to every object compiled with -ftime-trace
+    std::error_code ec;
+    std::string phase = currentPhase();
+    for (auto it = fs::recursive_directory_iterator(buildDir + "/CMakeFiles", ec);
+         !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        if (it->path().extension() != ".json" || fs::last_write_time(it->path(), ec) < buildStart) {
+            continue;
+        }
+        JsonValue document;
+        if (!JsonValue::parseFile(it->path().string(), document) || !document["traceEvents"].isArray()) {
+            continue;
+        }
+
+        // beginningOfTime is the compiler's start in wall-clock microseconds since the epoch (newer Clang)
+        int64_t offsetUs;
+        if (document["beginningOfTime"].isNumber()) {
+            auto startEpochUs = std::chrono::duration_cast<std::chrono::microseconds>(startWall.time_since_epoch()).count();
+            offsetUs = static_cast<int64_t>(document["beginningOfTime"].asNumber()) - startEpochUs;
+        } else {
+            // Older Clang: line the trace up so it ends when the file was written
+            int64_t totalUs = 0;
+            for (const auto& event : document["traceEvents"].items()) {
+                totalUs = std::max(totalUs, static_cast<int64_t>(event["ts"].asNumber() + event["dur"].asNumber()));
+            }
+            auto written = fs::last_write_time(it->path(), ec);
+            auto age = std::chrono::duration_cast<std::chrono::microseconds>(fs::file_time_type::clock::now() - written);
+            offsetUs = nowUs() - age.count() - totalUs;
+        }
+
+        std::string unit = fs::relative(it->path(), buildDir, ec).replace_extension().string();
+        for (const auto& event : document["traceEvents"].items()) {
+            std::string name = event["name"].asString();
+            double duration = event["dur"].asNumber();
+            // Totals are aggregates, not intervals; sub-millisecond events only add noise
+            if (event["ph"].asString() != "X" || name.rfind("Total ", 0) == 0 || duration < 1000) {
+                continue;
+            }
+            TraceSpan span;
+            span.name = name;
+            span.phase = phase;
+            span.process = "time-trace " + unit;
+            span.startUs = offsetUs + static_cast<int64_t>(event["ts"].asNumber());
+            span.endUs = span.startUs + static_cast<int64_t>(duration);
+            span.detail = event["args"]["detail"].asString();
+            record(span);
+        }
+    }
+}
+
+bool Trace::write() {
+    if (!enabled()) {
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<TraceSpan> sorted = spans;
+    std::stable_sort(sorted.begin(), sorted.end(), [](const TraceSpan& a, const TraceSpan& b) {
+        return a.startUs < b.startUs;
+    });
+
+    // Overlapping spans of one process go on separate rows: first row that is free again
+    std::map<std::string, int> pids;
+    std::map<std::string, std::vector<int64_t>> rowEnds;
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "Failed to write trace: " << path << std::endl;
+        return false;
+    }
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    for (const auto& span : sorted) {
+        if (!pids.count(span.process)) {
+            int pid = static_cast<int>(pids.size()) + 1;
+            pids[span.process] = pid;
+            out << (first ? "" : ",\n") << "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":" << pid
+                << ",\"args\":{\"name\":\"" << jsonEscape(span.process) << "\"}}";
+            first = false;
+        }
+
+        auto& ends = rowEnds[span.process];
+        size_t row = 0;
+        while (row < ends.size() && ends[row] > span.startUs) {
+            ++row;
+        }
+        if (row == ends.size()) {
+            ends.push_back(0);
+        }
+        ends[row] = span.endUs;
+
+        out << ",\n{\"ph\":\"X\",\"name\":\"" << jsonEscape(span.name) << "\",\"cat\":\"" << jsonEscape(span.phase)
+            << "\",\"pid\":" << pids[span.process] << ",\"tid\":" << row + 1 << ",\"ts\":" << span.startUs
+            << ",\"dur\":" << std::max<int64_t>(0, span.endUs - span.startUs) << ",\"args\":{\"phase\":\""
+            << jsonEscape(span.phase) << "\"";
+        if (span.process == "cpp-manager") {
+            out << ",\"exit_code\":" << span.exitCode << ",\"max_rss_kb\":" << span.maxRssKb;
+        }
+        if (!span.detail.empty()) {
+            out << ",\"detail\":\"" << jsonEscape(span.detail) << "\"";
+        }
+        out << "}}";
+    }
+    out << "\n]}\n";
+    std::cout << "Trace with " << sorted.size() << " spans written to " << path << std::endl;
+    return true;
+}
+
+std::map<std::string, std::pair<long, long>> readNinjaLog(const std::string& buildDir, fs::file_time_type since) {
+    // "start end mtime output hash", times in ms since that ninja run started. Only the latest
+    // entry of an output written after since belongs to the last run.
+    std::ifstream log(buildDir + "/.ninja_log");
+    std::map<std::string, std::pair<long, long>> latest;
+    std::string line;
+    while (std::getline(log, line)) {
+        std::istringstream fields(line);
+        long begin = 0, end = 0;
+        std::string mtime, output;
+        if (!line.empty() && line[0] != '#' && fields >> begin >> end >> mtime >> output) {
+            latest[output] = {begin, end};
+        }
+    }
+
+    for (auto it = latest.begin(); it != latest.end();) {
+        std::error_code ec;
+        fs::path outputPath = fs::path(it->first).is_absolute() ? fs::path(it->first) : fs::path(buildDir) / it->first;
+        auto written = fs::last_write_time(outputPath, ec);
+        if (ec || written < since || it->first == "build.ninja") {
+            it = latest.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return latest;
+}
@@ -0,0 +1,71 @@
+// src/Trace.h
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct TraceSpan {
+    std::string name;
+    std::string phase;
+    std::string process = "cpp-manager"; // groups spans into one row set in the trace viewer
+    int64_t startUs = 0;                 // microseconds since the trace started
+    int64_t endUs = 0;
+    int exitCode = 0;
+    long maxRssKb = 0;
+    std::string detail;
+};
+
+// Collects spans for every subprocess and phase and writes them as a Chrome
+// trace-event file (chrome://tracing, Perfetto) when enabled with --trace.
+class Trace {
+public:
+    static Trace& instance();
+
+    void enable(const std::string& outputPath);
+    bool enabled() const { return !path.empty(); }
+
+    int64_t nowUs() const;
+    std::string currentPhase();
+    void record(const TraceSpan& span);
+
+    // Per-TU compile times: the latest .ninja_log entries and Clang -ftime-trace files
+    // written after buildStart. buildStartUs is when the build tool was launched.
+    void mergeNinjaLog(const std::string& buildDir, std::filesystem::file_time_type buildStart, int64_t buildStartUs);
+    void mergeTimeTraces(const std::string& buildDir, std::filesystem::file_time_type buildStart);
+
+    bool write();
+
+    // Names the phase of every span recorded while it is alive, e.g. "build/configure"
+    class Phase {
+    public:
+        explicit Phase(const std::string& name);
+        ~Phase();
+        Phase(const Phase&) = delete;
+        Phase& operator=(const Phase&) = delete;
+
+    private:
+        int64_t startUs;
+    };
+
+private:
+    Trace();
+
+    std::string path;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::system_clock::time_point startWall;
+    std::mutex mutex;
+    std::vector<std::string> phases;
+    std::vector<TraceSpan> spans;
+};
+
+// Latest .ninja_log entry (start and end ms since that ninja run started) of every output written after since
+std::map<std::string, std::pair<long, long>> readNinjaLog(const std::string& buildDir,
+                                                         std::filesystem::file_time_type since);
+
+#endif // TRACE_H
@@ -1,4 +1,12 @@
+#include "Daemon.h"
 #include "ProjectManager.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
 #include <iostream>
 #include <string>
 #include <unordered_map>
@@ -21,16 +29,39 @@ std::vector<LLM> knownLLMs = {
 };
 
 void printHelp() {
-    std::cout << "Usage: cpp-manager <command> [options]\n"
+    std::cout << "Usage: cpp-manager [--trace <file>] <command> [options]\n"
               << "Commands:\n"
               << "  init <project-name>        Initialize a new C++ project\n"
-              << "  build                      Build the project\n"
+              << "  init [<name>] --from <spec.json> Generate a project from a spec, without prompts\n"
+              << "  add <package>...           Add Conan packages and resolve them in one run\n"
+              << "  analyze rebuild-cost [--top N] [--measure] Rank headers by recompile time per edit\n"
+              << "  bench [--filter <regex>] [--repetitions N] [--cpu N] [--threshold PCT] [--baseline <git-ref>] [--save-baseline]\n"
+              << "                             Run benchmarks pinned to one CPU, fail on regressions against the baseline\n"
+              << "        [--profile <profile>] [--build-dir <dir>] Benchmark build-<profile> or another build tree\n"
+              << "  build [--jobs N] [--explain] Build the project (Ninja when available, N defaults to all cores)\n"
+              << "        [--unity [--batch-size N] [--exclude <module>]] Compile src/ as unity batches\n"
+              << "        [--profile debug|release|release-lto|pgo|asan] [--march <arch>] [--train <command>]\n"
+              << "                             Optimization profile (default release, kept per build tree)\n"
+              << "        [--configs <profile>,...] [--build-dir <dir>] Build profiles side by side in build-<profile>\n"
+              << "        [--farm]             Schedule compiles and links itself, longest chains first\n"
+              << "  cache stats|clear|limit <size> Inspect or manage the local compiler cache\n"
+              << "  create bench <name>        Create a Google Benchmark in bench/\n"
               << "  create header <name>       Create a header file\n"
-              << "  create module <name> [--header] Create a module (with optional header)\n"
+              << "  create module <name> [--header|--cxx-module] Create a module (with optional header, or as a C++20 module)\n"
+              << "  daemon start|stop|status   Keep the project model resident; build, test, deps and src queries use it\n"
               << "  delete module <name>       Delete a module\n"
+              << "  deps graph [--dot]|rdeps <file>|fanout [N]|cycles Query the #include graph\n"
+              << "  gc [--max-age <age>]       Remove shared Conan packages unused for <age> (default 30d)\n"
               << "  help                       Show this help message\n"
+              << "  migrate modules [<header>...] Turn headers under include/ into C++20 named modules\n"
+              << "  pch analyze [--threshold N] Generate include/pch.h from the most included headers\n"
               << "  src [--list]               Edit or list source files\n"
-              << "  test                       Run tests\n";
+              << "        [--ext cpp,h] [--module <name>] [--changed-since <git-ref>] Only the matching files\n"
+              << "  src --grep <text> [filters] Search source files through a trigram index\n"
+              << "  src --perf                 Scaffold with members ordered by alignment, const& parameters, noexcept moves\n"
+              << "  test [--jobs N] [--junit <file>] [--changed [<git-ref>]] Run tests in parallel, sharded per test case\n"
+              << "        [--profile <profile>] [--build-dir <dir>] Test build-<profile> or another build tree\n"
+              << "  watch [build options]      Rebuild and re-run affected tests on every save\n";
 }
 
 void printLLMHelp() {
@@ -111,7 +142,65 @@ std::string selectOption(const std::vector<std::string>& options) {
     return options[selected];
 }
 
-int main(int argc, char* argv[]) {
+// The value of a numeric option: a whole number of at least minimum, or a usage message and false
+static bool parseCount(const std::string& arg, const std::string& name, unsigned& value, unsigned minimum = 1) {
+    char* end = nullptr;
+    errno = 0;
+    unsigned long parsed = 0;
+    if (!arg.empty() && arg[0] >= '0' && arg[0] <= '9') {
+        parsed = std::strtoul(arg.c_str(), &end, 10);
+    }
+    if (!end || *end || errno == ERANGE || parsed < minimum || parsed > UINT_MAX) {
+        std::cerr << name << " takes a whole number" << (minimum == 1 ? " above zero" : "") << ", not \"" << arg
+                  << "\"" << std::endl;
+        return false;
+    }
+    value = static_cast<unsigned>(parsed);
+    return true;
+}
+
+// A percentage option: a finite number of zero or more, or a usage message and false
+static bool parsePercent(const std::string& arg, const std::string& name, double& value) {
+    char* end = nullptr;
+    double parsed = -1;
+    if (!arg.empty() && (std::isdigit(static_cast<unsigned char>(arg[0])) || arg[0] == '.')) {
+        parsed = std::strtod(arg.c_str(), &end);
+    }
+    if (!end || *end || !std::isfinite(parsed) || parsed < 0) {
+        std::cerr << name << " takes a percentage of zero or more, not \"" << arg << "\"" << std::endl;
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+// A build tree option: a directory inside the project, made relative to it, or a usage message and false
+static bool parseBuildDir(const std::string& arg, const std::string& name, std::string& value) {
+    std::filesystem::path project = std::filesystem::current_path();
+    std::string relative = std::filesystem::absolute(arg).lexically_normal().lexically_relative(project).string();
+    if (!relative.empty() && relative.back() == '/') {
+        relative.pop_back();
+    }
+    if (arg.empty() || relative.empty() || relative == "." || relative.compare(0, 2, "..") == 0) {
+        std::cerr << name << " takes a directory inside the project, not \"" << arg << "\"" << std::endl;
+        return false;
+    }
+    value = relative;
+    return true;
+}
+
+// Commands a running daemon answers from its warm state; the rest always run here
+static bool forwardable(const std::vector<std::string>& args) {
+    if (args.empty() || std::getenv("CPP_MANAGER_NO_DAEMON")) {
+        return false;
+    }
+    const std::string& command = args[0];
+    return command == "build" || command == "test" || command == "deps" ||
+           (command == "src" && args.size() >= 2 && (args[1] == "--list" || args[1] == "--grep")) ||
+           (command == "daemon" && args.size() == 2 && (args[1] == "stop" || args[1] == "status"));
+}
+
+int runCommand(int argc, char* argv[]) {
     if (argc < 2) {
         printHelp();
         return 1;
@@ -119,10 +208,27 @@ int main(int argc, char* argv[]) {
 
     std::unordered_map<std::string, std::function<void()>> commands;
     bool llmLoaded = false;
+    int exitCode = 0;
 
     commands["init"] = [&]() {
-        if (argc == 3) {
-            std::string projectName = argv[2];
+        // init <name> | init [<name>] --from <spec.json>
+        std::string projectName, specPath;
+        for (int i = 2; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--from" && i + 1 < argc) {
+                specPath = argv[++i];
+            } else if (projectName.empty() && arg[0] != '-') {
+                projectName = arg;
+            } else {
+                projectName.clear();
+                specPath.clear();
+                break;
+            }
+        }
+        if (!specPath.empty()) {
+            ProjectManager manager(projectName);
+            exitCode = manager.initializeFromSpec(specPath) ? 0 : 1;
+        } else if (!projectName.empty()) {
             ProjectManager manager(projectName);
             manager.initializeProject();
         } else {
@@ -130,14 +236,239 @@ int main(int argc, char* argv[]) {
         }
     };
 
+    commands["add"] = [&]() {
+        if (argc >= 3) {
+            ProjectManager manager(".");
+            exitCode = manager.addDependencies(std::vector<std::string>(argv + 2, argv + argc)) ? 0 : 1;
+        } else {
+            printHelp();
+        }
+    };
+
+    auto parseBuildOptions = [&](BuildOptions& options, int first) {
+        for (int i = first; i < argc; ++i) {
+            std::string arg = argv[i];
+            if ((arg == "--jobs" || arg == "-j") && i + 1 < argc) {
+                if (!parseCount(argv[++i], arg, options.jobs)) {
+                    return false;
+                }
+            } else if (arg == "--explain") {
+                options.explain = true;
+            } else if (arg == "--unity") {
+                options.unity = true;
+            } else if (arg == "--batch-size" && i + 1 < argc) {
+                if (!parseCount(argv[++i], arg, options.unityBatchSize)) {
+                    return false;
+                }
+            } else if (arg == "--exclude" && i + 1 < argc) {
+                options.unityExclude.push_back(argv[++i]);
+            } else if (arg == "--profile" && i + 1 < argc) {
+                options.profile = argv[++i];
+            } else if (arg == "--march" && i + 1 < argc) {
+                options.march = argv[++i];
+            } else if (arg == "--train" && i + 1 < argc) {
+                options.trainCommand = argv[++i];
+            } else if (arg == "--farm") {
+                options.farm = true;
+            } else if (arg == "--build-dir" && i + 1 < argc) {
+                if (!parseBuildDir(argv[++i], arg, options.buildDir)) {
+                    return false;
+                }
+            } else if (arg == "--prepared") {
+                // Internal: the per-tree builds of `build --configs`
+                options.prepared = true;
+            } else if (arg == "--configs" && i + 1 < argc) {
+                std::string list = argv[++i];
+                for (size_t begin = 0, end; begin <= list.size(); begin = end + 1) {
+                    end = std::min(list.find(',', begin), list.size());
+                    if (end > begin) {
+                        options.configs.push_back(list.substr(begin, end - begin));
+                    }
+                }
+            } else {
+                std::cerr << "Unknown build option: " << arg << "\n";
+                printHelp();
+                return false;
+            }
+        }
+        return true;
+    };
+
     commands["build"] = [&]() {
+        BuildOptions options;
+        if (!parseBuildOptions(options, 2)) {
+            exitCode = 1;
+            return;
+        }
+        ProjectManager manager(".");
+        exitCode = manager.buildProject(options) ? 0 : 1;
+    };
+
+    commands["watch"] = [&]() {
+        BuildOptions options;
+        if (!parseBuildOptions(options, 2)) {
+            exitCode = 1;
+            return;
+        }
+        ProjectManager manager(".");
+        manager.watchProject(options);
+    };
+
+    commands["cache"] = [&]() {
+        if (argc >= 3) {
+            std::string argument = (argc >= 4) ? argv[3] : "";
+            ProjectManager manager(".");
+            exitCode = manager.cacheCommand(argv[2], argument) ? 0 : 1;
+        } else {
+            printHelp();
+        }
+    };
+
+    commands["analyze"] = [&]() {
+        if (argc >= 3 && std::string(argv[2]) == "rebuild-cost") {
+            unsigned top = 20;
+            bool measure = false;
+            for (int i = 3; i < argc; ++i) {
+                std::string arg = argv[i];
+                if (arg == "--top" && i + 1 < argc) {
+                    if (!parseCount(argv[++i], "--top", top)) {
+                        exitCode = 1;
+                        return;
+                    }
+                } else if (arg == "--measure") {
+                    measure = true;
+                } else {
+                    printHelp();
+                    exitCode = 1;
+                    return;
+                }
+            }
+            ProjectManager manager(".");
+            exitCode = manager.analyzeRebuildCost(top, measure) ? 0 : 1;
+        } else {
+            printHelp();
+        }
+    };
+
+    commands["deps"] = [&]() {
+        if (argc >= 3 && argc <= 4) {
+            std::string argument = (argc == 4) ? argv[3] : "";
+            unsigned limit = 20;
+            if (std::string(argv[2]) == "fanout" && !argument.empty() && !parseCount(argument, "fanout", limit)) {
+                exitCode = 1;
+                return;
+            }
+            ProjectManager manager(".");
+            exitCode = manager.depsCommand(argv[2], argument, limit) ? 0 : 1;
+        } else {
+            printHelp();
+        }
+    };
+
+    commands["gc"] = [&]() {
+        std::string maxAge = "30d";
+        if (argc == 4 && std::string(argv[2]) == "--max-age") {
+            maxAge = argv[3];
+        } else if (argc != 2) {
+            printHelp();
+            exitCode = 1;
+            return;
+        }
         ProjectManager manager(".");
-        manager.buildProject();
+        exitCode = manager.collectGarbage(maxAge) ? 0 : 1;
+    };
+
+    commands["pch"] = [&]() {
+        if (argc >= 3 && std::string(argv[2]) == "analyze") {
+            unsigned threshold = 0;
+            if (argc == 5 && std::string(argv[3]) == "--threshold" && !parseCount(argv[4], argv[3], threshold)) {
+                exitCode = 1;
+                return;
+            }
+            ProjectManager manager(".");
+            exitCode = manager.analyzePrecompiledHeader(threshold) ? 0 : 1;
+        } else {
+            printHelp();
+        }
     };
 
     commands["test"] = [&]() {
+        TestOptions options;
+        for (int i = 2; i < argc; ++i) {
+            std::string arg = argv[i];
+            if ((arg == "--jobs" || arg == "-j") && i + 1 < argc) {
+                if (!parseCount(argv[++i], arg, options.jobs)) {
+                    exitCode = 1;
+                    return;
+                }
+            } else if (arg == "--junit" && i + 1 < argc) {
+                options.junitPath = argv[++i];
+            } else if (arg == "--changed") {
+                options.changedOnly = true;
+                if (i + 1 < argc && argv[i + 1][0] != '-') {
+                    options.changedSince = argv[++i];
+                }
+            } else if (arg == "--profile" && i + 1 < argc) {
+                options.profile = argv[++i];
+            } else if (arg == "--build-dir" && i + 1 < argc) {
+                if (!parseBuildDir(argv[++i], arg, options.buildDir)) {
+                    exitCode = 1;
+                    return;
+                }
+            } else {
+                std::cerr << "Unknown test option: " << arg << "\n";
+                printHelp();
+                exitCode = 1;
+                return;
+            }
+        }
+        ProjectManager manager(".");
+        exitCode = manager.runTests(options);
+    };
+
+    commands["bench"] = [&]() {
+        BenchOptions options;
+        for (int i = 2; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--filter" && i + 1 < argc) {
+                options.filter = argv[++i];
+            } else if (arg == "--repetitions" && i + 1 < argc) {
+                if (!parseCount(argv[++i], arg, options.repetitions)) {
+                    exitCode = 1;
+                    return;
+                }
+            } else if (arg == "--cpu" && i + 1 < argc) {
+                unsigned cpu = 0;
+                if (!parseCount(argv[++i], arg, cpu, 0)) {
+                    exitCode = 1;
+                    return;
+                }
+                options.cpu = static_cast<int>(std::min<unsigned>(cpu, INT_MAX));
+            } else if (arg == "--threshold" && i + 1 < argc) {
+                if (!parsePercent(argv[++i], arg, options.threshold)) {
+                    exitCode = 1;
+                    return;
+                }
+            } else if (arg == "--baseline" && i + 1 < argc) {
+                options.baseline = argv[++i];
+            } else if (arg == "--save-baseline") {
+                options.saveBaseline = true;
+            } else if (arg == "--profile" && i + 1 < argc) {
+                options.profile = argv[++i];
+            } else if (arg == "--build-dir" && i + 1 < argc) {
+                if (!parseBuildDir(argv[++i], arg, options.buildDir)) {
+                    exitCode = 1;
+                    return;
+                }
+            } else {
+                std::cerr << "Unknown bench option: " << arg << "\n";
+                printHelp();
+                exitCode = 1;
+                return;
+            }
+        }
         ProjectManager manager(".");
-        manager.runTests();
+        exitCode = manager.runBenchmarks(options);
     };
 
     commands["create"] = [&]() {
@@ -147,9 +478,15 @@ int main(int argc, char* argv[]) {
             ProjectManager manager(".");
             if (type == "header") {
                 manager.createHeader(name);
+            } else if (type == "bench") {
+                exitCode = manager.createBenchmark(name) ? 0 : 1;
             } else if (type == "module") {
-                bool createHeader = (argc >= 5 && std::string(argv[4]) == "--header");
-                manager.createModule(name, createHeader);
+                bool createHeader = false, cxxModule = false;
+                for (int i = 4; i < argc; ++i) {
+                    createHeader = createHeader || std::string(argv[i]) == "--header";
+                    cxxModule = cxxModule || std::string(argv[i]) == "--cxx-module";
+                }
+                manager.createModule(name, createHeader, cxxModule);
             } else {
                 std::cerr << "Invalid create command.\n";
                 printHelp();
@@ -159,6 +496,15 @@ int main(int argc, char* argv[]) {
         }
     };
 
+    commands["migrate"] = [&]() {
+        if (argc >= 3 && std::string(argv[2]) == "modules") {
+            ProjectManager manager(".");
+            exitCode = manager.migrateToModules(std::vector<std::string>(argv + 3, argv + argc)) ? 0 : 1;
+        } else {
+            printHelp();
+        }
+    };
+
     commands["delete"] = [&]() {
         if (argc == 4 && std::string(argv[2]) == "module") {
             std::string name = argv[3];
@@ -171,8 +517,67 @@ int main(int argc, char* argv[]) {
 
     commands["src"] = [&]() {
         std::string subCommand = (argc >= 3) ? argv[2] : "";
+        if (subCommand != "--list" && subCommand != "--grep") {
+            ProjectManager manager(".");
+            manager.srcCommand(subCommand);
+            return;
+        }
+        std::string text;
+        int first = 3;
+        if (subCommand == "--grep" && argc >= 4) {
+            text = argv[3];
+            first = 4;
+        }
+        SourceOptions options;
+        for (int i = first; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--ext" && i + 1 < argc) {
+                std::string list = argv[++i];
+                for (size_t begin = 0, end; begin <= list.size(); begin = end + 1) {
+                    end = std::min(list.find(',', begin), list.size());
+                    if (end > begin) {
+                        options.extensions.push_back(list.substr(begin, end - begin));
+                    }
+                }
+            } else if (arg == "--module" && i + 1 < argc) {
+                options.module = argv[++i];
+            } else if (arg == "--changed-since" && i + 1 < argc) {
+                options.changedSince = argv[++i];
+            } else {
+                std::cerr << "Unknown src option: " << arg << "\n";
+                printHelp();
+                exitCode = 1;
+                return;
+            }
+        }
         ProjectManager manager(".");
-        manager.srcCommand(subCommand);
+        bool ok = subCommand == "--list" ? manager.listSourceFiles(options) : manager.grepSourceFiles(text, options);
+        exitCode = ok ? 0 : 1;
+    };
+
+    commands["daemon"] = [&]() {
+        std::string subCommand = (argc == 3) ? argv[2] : "";
+        if (subCommand == "start") {
+            // Request children run the command as if it had been typed here, minus the daemon
+            auto handler = [](const std::vector<std::string>& requestArgs) {
+                std::vector<std::string> storage = {"cpp-manager"};
+                storage.insert(storage.end(), requestArgs.begin(), requestArgs.end());
+                std::vector<char*> requestArgv;
+                for (auto& arg : storage) {
+                    requestArgv.push_back(&arg[0]);
+                }
+                requestArgv.push_back(nullptr);
+                return runCommand(static_cast<int>(storage.size()), requestArgv.data());
+            };
+            exitCode = Daemon::start(handler, [] { ProjectManager(".").warmResidentState(); }) ? 0 : 1;
+        } else if (subCommand == "stop" || subCommand == "status") {
+            // Only reached when forwarding found no daemon
+            std::cerr << "No daemon is running for this project.\n";
+            exitCode = 1;
+        } else {
+            printHelp();
+            exitCode = 1;
+        }
     };
 
     commands["help"] = [&]() {
@@ -232,12 +637,40 @@ int main(int argc, char* argv[]) {
 
     std::string command = argv[1];
     if (commands.find(command) != commands.end()) {
-        commands[command]();
+        {
+            Trace::Phase phase(command);
+            commands[command]();
+        }
+        if (!Trace::instance().write()) {
+            exitCode = 1;
+        }
     } else {
         std::cerr << "Invalid command or arguments.\n";
         printHelp();
         return 1;
     }
 
-    return 0;
-}
\ No newline at end of file
+    return exitCode;
+}
+
+int main(int argc, char* argv[]) {
+    // --trace <file> is a global option: only before the command, so command arguments are left alone
+    std::vector<char*> args = {argv[0]};
+    int first = 1;
+    while (first + 1 < argc && std::string(argv[first]) == "--trace") {
+        Trace::instance().enable(argv[first + 1]);
+        first += 2;
+    }
+    args.insert(args.end(), argv + first, argv + argc);
+
+    // Traced runs stay local, the trace is written by this process
+    std::vector<std::string> command(args.begin() + 1, args.end());
+    int exitCode = 0;
+    if (!Trace::instance().enabled() && forwardable(command) && Daemon::forward(command, exitCode)) {
+        return exitCode;
+    }
+
+    argc = static_cast<int>(args.size());
+    args.push_back(nullptr);
+    return runCommand(argc, args.data());
+}
@@ -0,0 +1,69 @@
+// test/CompileFarmTest.cpp
+#include "CompileFarm.h"
+#include <gtest/gtest.h>
+
+namespace {
+
+FarmJob job(double estimate, std::vector<size_t> dependencies = {}) {
+    FarmJob result;
+    result.estimate = estimate;
+    result.dependencies = std::move(dependencies);
+    return result;
+}
+
+FarmJob shell(const std::string& script, std::vector<size_t> dependencies = {}) {
+    FarmJob result;
+    result.name = script;
+    result.argv = {"sh", "-c", script};
+    result.dependencies = std::move(dependencies);
+    return result;
+}
+
+TEST(CompileFarmTest, CriticalPathIsTheLongestChainAJobStarts) {
+    // Two compiles feed a link, a third compile feeds nothing
+    std::vector<FarmJob> jobs = {job(2), job(5), job(1, {0, 1}), job(3)};
+    EXPECT_EQ(CompileFarm::criticalPaths(jobs), (std::vector<double>{3, 6, 1, 3}));
+}
+
+TEST(CompileFarmTest, CriticalPathTakesTheLongerBranch) {
+    // 0 -> {1, 2} -> 3 -> 4
+    std::vector<FarmJob> jobs = {job(1), job(4, {0}), job(1, {0}), job(2, {1, 2}), job(0.5, {3})};
+    EXPECT_EQ(CompileFarm::criticalPaths(jobs), (std::vector<double>{7.5, 6.5, 3.5, 2.5, 0.5}));
+}
+
+TEST(CompileFarmTest, CriticalPathsTerminateOnCycles) {
+    std::vector<FarmJob> jobs = {job(1, {1}), job(2, {0})};
+    auto paths = CompileFarm::criticalPaths(jobs);
+    ASSERT_EQ(paths.size(), 2u);
+    EXPECT_GE(paths[0], 1);
+    EXPECT_GE(paths[1], 2);
+}
+
+TEST(CompileFarmTest, RunsDependenciesFirst) {
+    CompileFarm farm(2);
+    ASSERT_EQ(farm.workerCount(), 2u);
+    std::vector<FarmJob> jobs = {shell("echo compile"), shell("echo link", {0, 2}), shell("echo compile2")};
+    std::vector<size_t> order;
+    std::vector<std::string> output(jobs.size());
+    EXPECT_TRUE(farm.run(jobs, [&](size_t index, const ProcessResult& result) {
+        order.push_back(index);
+        output[index] = result.out;
+        EXPECT_EQ(result.exitCode, 0);
+    }));
+    ASSERT_EQ(order.size(), 3u);
+    EXPECT_EQ(order.back(), 1u);
+    EXPECT_EQ(output[1], "link\n");
+}
+
+TEST(CompileFarmTest, StopsAfterAFailure) {
+    CompileFarm farm(1);
+    std::vector<FarmJob> jobs = {shell("exit 3"), shell("echo link", {0})};
+    std::vector<size_t> finished;
+    EXPECT_FALSE(farm.run(jobs, [&](size_t index, const ProcessResult& result) {
+        finished.push_back(index);
+        EXPECT_EQ(result.exitCode, 3);
+    }));
+    EXPECT_EQ(finished, (std::vector<size_t>{0}));
+}
+
+} // namespace
@@ -0,0 +1,51 @@
+// test/FileWatcherTest.cpp
+#include "FileWatcher.h"
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <poll.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+class FileWatcherTest : public ::testing::Test {
+protected:
+    fs::path dir;
+
+    void SetUp() override {
+        std::string pattern = (fs::temp_directory_path() / "cpp-manager-test-XXXXXX").string();
+        dir = mkdtemp(pattern.data());
+    }
+    void TearDown() override { fs::remove_all(dir); }
+
+    // Waits up to a second for events, then reads them
+    static bool changed(FileWatcher& watcher) {
+        pollfd fd = {watcher.descriptor(), POLLIN, 0};
+        return poll(&fd, 1, 1000) > 0 && watcher.readChanges();
+    }
+};
+
+TEST_F(FileWatcherTest, SourceDirectoryCreatedLaterIsWatched) {
+    FileWatcher watcher(dir.string());
+    ASSERT_TRUE(watcher.valid());
+
+    fs::create_directory(dir / "bench");
+    EXPECT_TRUE(changed(watcher));
+    std::ofstream(dir / "bench" / "sort.cpp") << "int main() {}\n";
+    EXPECT_TRUE(changed(watcher));
+}
+
+TEST_F(FileWatcherTest, OtherRootEntriesAreIgnored) {
+    FileWatcher watcher(dir.string());
+    ASSERT_TRUE(watcher.valid());
+
+    fs::create_directory(dir / "docs");
+    std::ofstream(dir / "README.md") << "notes\n";
+    EXPECT_FALSE(changed(watcher));
+    std::ofstream(dir / "CMakeLists.txt") << "project(app)\n";
+    EXPECT_TRUE(changed(watcher));
+}
+
+} // namespace
@@ -0,0 +1,112 @@
+// test/IncludeGraphTest.cpp
+#include "IncludeGraph.h"
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+class IncludeGraphTest : public ::testing::Test {
+protected:
+    fs::path dir;
+
+    void SetUp() override {
+        std::string pattern = (fs::temp_directory_path() / "cpp-manager-test-XXXXXX").string();
+        dir = mkdtemp(pattern.data());
+    }
+    void TearDown() override { fs::remove_all(dir); }
+
+    void write(const std::string& name, const std::string& content) {
+        fs::create_directories((dir / name).parent_path());
+        std::ofstream(dir / name, std::ios::binary) << content;
+    }
+    std::string indexPath() const { return (dir / "include-index").string(); }
+};
+
+TEST(IncludeGraphParseTest, IncludesAndImports) {
+    std::string source = "#include \"a.h\"\n  #  include <vector>\nimport \"b.h\";\nimport <string>;\n"
+                         "export module net.socket;\nimport net.address;\nmodule util;\n// #include \"no.h\"\n"
+                         "#include \"unterminated.h\n";
+    auto directives = IncludeGraph::parse(source.data(), source.size());
+    std::vector<std::pair<std::string, bool>> found;
+    for (const auto& directive : directives) {
+        found.push_back({directive.header, directive.angled});
+    }
+    EXPECT_EQ(found, (std::vector<std::pair<std::string, bool>>{{"a.h", false},
+                                                                {"vector", true},
+                                                                {"b.h", false},
+                                                                {"string", true},
+                                                                {"net/address.cppm", false},
+                                                                {"util.cppm", false}}));
+}
+
+TEST(IncludeGraphParseTest, ResolvePrefersTheIncludingDirectory) {
+    std::set<std::string> files = {"src/net/util.h", "include/util.h", "src/config.h"};
+    auto exists = [&](const std::string& path) { return files.count(path) != 0; };
+    EXPECT_EQ(IncludeGraph::resolve("src/net/socket.cpp", {"util.h", false}, exists), "src/net/util.h");
+    EXPECT_EQ(IncludeGraph::resolve("src/net/socket.cpp", {"util.h", true}, exists), "include/util.h");
+    EXPECT_EQ(IncludeGraph::resolve("src/net/socket.cpp", {"../config.h", false}, exists), "src/config.h");
+    EXPECT_EQ(IncludeGraph::resolve("src/net/socket.cpp", {"vector", true}, exists), "");
+}
+
+TEST_F(IncludeGraphTest, CyclesAreStronglyConnectedComponents) {
+    write("src/main.cpp", "#include \"a.h\"\n#include \"x.h\"\n");
+    write("src/a.h", "#include \"b.h\"\n");
+    write("src/b.h", "#include \"c.h\"\n");
+    write("src/c.h", "#include \"a.h\"\n");
+    write("src/x.h", "#include \"x.h\"\n");
+    write("include/leaf.h", "");
+    IncludeGraph graph(dir.string());
+    graph.update(indexPath());
+
+    EXPECT_EQ(graph.cycles(),
+              (std::vector<std::vector<std::string>>{{"src/a.h", "src/b.h", "src/c.h"}, {"src/x.h"}}));
+    EXPECT_EQ(graph.includers("src/c.h"), (std::set<std::string>{"src/a.h", "src/b.h", "src/main.cpp"}));
+    EXPECT_EQ(graph.includers("src/c.h", {"src/b.h", "src/c.h"}), (std::set<std::string>{}));
+    auto fanout = graph.fanout();
+    ASSERT_EQ(fanout.size(), 5u);
+    EXPECT_EQ(fanout.back(), (std::pair<std::string, size_t>{"include/leaf.h", 0}));
+}
+
+TEST_F(IncludeGraphTest, IndexRoundTrip) {
+    write("src/main.cpp", "#include \"util.h\"\n#include <vector>\n");
+    write("include/util.h", "#include \"detail/impl.h\"\n");
+    write("include/detail/impl.h", "");
+    IncludeGraph first(dir.string());
+    first.update(indexPath());
+    EXPECT_EQ(first.reparsed(), 3u);
+
+    // Unchanged files come from the index with their directives and edges
+    IncludeGraph second(dir.string());
+    second.update(indexPath());
+    EXPECT_EQ(second.reparsed(), 0u);
+    EXPECT_EQ(second.files(), first.files());
+    for (const auto& file : first.files()) {
+        EXPECT_EQ(second.includes(file), first.includes(file)) << file;
+        ASSERT_EQ(second.directives(file).size(), first.directives(file).size()) << file;
+    }
+    EXPECT_TRUE(second.directives("src/main.cpp")[1].angled);
+
+    // Only the new and the edited file are parsed; the new one changes what main.cpp resolves to
+    write("src/util.h", "");
+    write("include/util.h", "#include \"detail/impl.h\"\n#include \"extra.h\"\n");
+    IncludeGraph third(dir.string());
+    third.update(indexPath());
+    EXPECT_EQ(third.reparsed(), 2u);
+    EXPECT_EQ(third.includes("src/main.cpp"), (std::set<std::string>{"src/util.h"}));
+    EXPECT_EQ(third.includes("include/util.h"), (std::set<std::string>{"include/detail/impl.h"}));
+}
+
+TEST_F(IncludeGraphTest, CorruptIndexIsRebuilt) {
+    write("src/main.cpp", "#include \"util.h\"\n");
+    write("src/util.h", "");
+    std::ofstream(indexPath()) << "cpp-manager include index 3 zz\nsrc/main.cpp\tgarbage 7 7 7\n\nno tab\n";
+    IncludeGraph graph(dir.string());
+    graph.update(indexPath());
+    EXPECT_EQ(graph.includes("src/main.cpp"), (std::set<std::string>{"src/util.h"}));
+}
+
+} // namespace
@@ -0,0 +1,42 @@
+// test/ProcessTest.cpp
+#include "Process.h"
+#include <gtest/gtest.h>
+#include <csignal>
+
+namespace {
+
+ProcessSpec captured(const std::vector<std::string>& argv) {
+    ProcessSpec spec;
+    spec.argv = argv;
+    spec.stdoutMode = ProcessOutput::Capture;
+    spec.stderrMode = ProcessOutput::Capture;
+    return spec;
+}
+
+TEST(ProcessTest, ReportsExitCodesAndOutput) {
+    ProcessResult result = Process::run(captured({"sh", "-c", "echo out; echo err >&2; exit 3"}));
+    EXPECT_EQ(result.exitCode, 3);
+    EXPECT_EQ(result.out, "out\n");
+    EXPECT_EQ(result.err, "err\n");
+    EXPECT_EQ(Process::run(captured({"cpp-manager-no-such-program"})).exitCode, 127);
+}
+
+TEST(ProcessTest, KillsChildrenPastTheirTimeout) {
+    ProcessSpec spec = captured({"sleep", "10"});
+    spec.timeoutSeconds = 0.2;
+    ProcessResult result = Process::run(spec);
+    EXPECT_TRUE(result.timedOut);
+    EXPECT_EQ(result.exitCode, 128 + SIGKILL);
+    EXPECT_LT(result.seconds, 5);
+}
+
+TEST(ProcessTest, LostExitStatusIsNotSuccess) {
+    // With SIGCHLD ignored the kernel reaps children itself and wait4 fails with ECHILD
+    auto previous = std::signal(SIGCHLD, SIG_IGN);
+    ProcessResult result = Process::run(captured({"true"}));
+    std::signal(SIGCHLD, previous);
+    EXPECT_NE(result.exitCode, 0);
+    EXPECT_NE(result.err.find("wait4"), std::string::npos);
+}
+
+} // namespace
@@ -0,0 +1,171 @@
+// test/ProjectManagerTest.cpp
+#include "../src/ProjectManager.h" // include/ holds an outdated copy of the header
+#include "Process.h"
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <tuple>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+class ProjectManagerTest : public ::testing::Test {
+protected:
+    fs::path dir;
+
+    void SetUp() override {
+        std::string pattern = (fs::temp_directory_path() / "cpp-manager-test-XXXXXX").string();
+        dir = mkdtemp(pattern.data());
+    }
+    void TearDown() override { fs::remove_all(dir); }
+
+    // Generates a project from a spec with one performance-codegen struct and returns its source
+    std::string generate(const std::string& structSpec) {
+        std::string specPath = (dir / "spec.json").string();
+        std::ofstream(specPath) << R"({"name": "app", "git": false, "codegen": "performance",
+                                       "modules": [{"name": "model", "classes": [)"
+                                << structSpec << "]}]}";
+        ProjectManager manager((dir / "app").string());
+        if (!manager.initializeFromSpec(specPath)) {
+            return "";
+        }
+        std::ifstream in(dir / "app" / "src" / "model.cpp");
+        return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    }
+
+    // Output of a syntax-only compile of source with the includes its member types need; empty when it compiles
+    std::string compileErrors(const std::string& source, const std::string& includes) {
+        std::ofstream(dir / "app" / "src" / "model.cpp") << includes << source;
+        ProcessSpec spec;
+        const char* cxx = getenv("CXX");
+        spec.argv = {cxx ? cxx : "c++", "-std=c++17", "-fsyntax-only", "-I" + (dir / "app" / "include").string(),
+                     (dir / "app" / "src" / "model.cpp").string()};
+        spec.stdoutMode = ProcessOutput::Capture;
+        spec.stderrMode = ProcessOutput::MergeIntoStdout;
+        ProcessResult result = Process::run(spec);
+        return result.exitCode == 0 ? "" : result.out + "exit code " + std::to_string(result.exitCode);
+    }
+};
+
+TEST_F(ProjectManagerTest, DependenciesUseTheCMakeNamesConanGenerated) {
+    // A stand-in for conan whose install writes what CMakeDeps writes for zlib, whose CMake package is ZLIB,
+    // and for bzip2, which zlib does not need and which is not required
+    setenv("HOME", dir.c_str(), 1);
+    setenv("CONAN_HOME", (dir / "conan-home").c_str(), 1);
+    fs::path generated = dir / "generated";
+    fs::create_directories(generated);
+    using Package = std::tuple<std::string, std::string, std::string>;
+    for (const auto& [file, package, target] : {Package{"ZLIB", "zlib", "ZLIB::ZLIB"}, {"BZip2", "bzip2", "BZip2::BZip2"}}) {
+        std::ofstream(generated / (file + "Config.cmake"))
+            << "include(${CMAKE_CURRENT_LIST_DIR}/" << file << "Targets.cmake)\n";
+        std::ofstream(generated / (file + "Targets.cmake"))
+            << "foreach(_COMPONENT ${" << package << "_COMPONENT_NAMES} )\n    if(NOT TARGET ${_COMPONENT})\n"
+            << "        add_library(${_COMPONENT} INTERFACE IMPORTED)\n    endif()\nendforeach()\n\n"
+            << "if(NOT TARGET " << target << ")\n    add_library(" << target << " INTERFACE IMPORTED)\nendif()\n";
+    }
+    std::ofstream(dir / "spec.json") << R"({"name": "app", "git": false})";
+    ProjectManager manager((dir / "app").string());
+    ASSERT_TRUE(manager.initializeFromSpec((dir / "spec.json").string()));
+    fs::create_directories(dir / "app" / "manager" / "bin");
+    std::ofstream(dir / "app" / "manager" / "bin" / "conan")
+        << "#!/bin/sh\nfor a; do case $a in --output-folder=*) cp " << generated.string()
+        << "/* \"${a#--output-folder=}\";; esac; done\n";
+    fs::permissions(dir / "app" / "manager" / "bin" / "conan", fs::perms::owner_all);
+
+    ASSERT_TRUE(manager.addDependencies({"zlib/1.3"}));
+    std::ifstream in(dir / "app" / "CMakeLists.txt");
+    std::string cmake((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    EXPECT_NE(cmake.find("find_package(ZLIB REQUIRED)\n"), std::string::npos);
+    EXPECT_NE(cmake.find("    target_link_libraries(${target} PRIVATE ZLIB::ZLIB)\n"), std::string::npos);
+    EXPECT_EQ(cmake.find("zlib::zlib"), std::string::npos);
+    EXPECT_EQ(cmake.find("BZip2"), std::string::npos);
+}
+
+TEST_F(ProjectManagerTest, NamespaceScopeStaticsKeepAHeader) {
+    std::ofstream(dir / "spec.json") << R"({"name": "app", "git": false})";
+    ProjectManager manager((dir / "app").string());
+    ASSERT_TRUE(manager.initializeFromSpec((dir / "spec.json").string()));
+    std::ofstream(dir / "app" / "include" / "config.h")
+        << "#pragma once\nnamespace config {\n    static int retries = 3;\n}\n";
+    std::ofstream(dir / "app" / "include" / "counter.h")
+        << "#pragma once\nnamespace counter {\nclass Counter {\npublic:\n    static int instances;\n"
+        << "    static_assert(sizeof(int) >= 4);\n};\n}\n";
+
+    ASSERT_TRUE(manager.migrateToModules({"config", "counter"}));
+    EXPECT_TRUE(fs::exists(dir / "app" / "include" / "config.h"));
+    EXPECT_FALSE(fs::exists(dir / "app" / "src" / "config.cppm"));
+    EXPECT_TRUE(fs::exists(dir / "app" / "src" / "counter.cppm"));
+}
+
+TEST_F(ProjectManagerTest, MembersAreOrderedByAlignment) {
+    std::string source = generate(R"({"type": "struct", "name": "Particle", "attributes": [
+        {"name": "alive", "type": "bool"}, {"name": "x", "type": "double"},
+        {"name": "id", "type": "int"}, {"name": "label", "type": "std::string"}]})");
+    ASSERT_FALSE(source.empty());
+
+    // Widest alignment first, the order entered among equals
+    size_t x = source.find("    double x;");
+    size_t label = source.find("    std::string label;");
+    size_t id = source.find("    int id;");
+    size_t alive = source.find("    bool alive;");
+    ASSERT_NE(alive, std::string::npos);
+    EXPECT_LT(x, label);
+    EXPECT_LT(label, id);
+    EXPECT_LT(id, alive);
+
+    EXPECT_NE(source.find("Particle(double x, std::string label, int id, bool alive)\n"
+                          "        : x(x), label(std::move(label)), id(id), alive(alive) {}"),
+              std::string::npos);
+    EXPECT_NE(source.find("Particle(const Particle&) = default;"), std::string::npos);
+    EXPECT_NE(source.find("Particle(Particle&&) noexcept = default;"), std::string::npos);
+    EXPECT_EQ(source.find("SoA"), std::string::npos);
+    EXPECT_EQ(compileErrors(source, "#include <string>\n"), "");
+}
+
+TEST_F(ProjectManagerTest, StructureOfArraysKeepsOneArrayPerMember) {
+    std::string source = generate(R"({"type": "struct", "name": "Particle", "soa": true, "attributes": [
+        {"name": "alive", "type": "bool"}, {"name": "x", "type": "double"},
+        {"name": "label", "type": "std::string"}]})");
+    ASSERT_FALSE(source.empty());
+
+    size_t soa = source.find("struct ParticleSoA {");
+    ASSERT_NE(soa, std::string::npos);
+    EXPECT_NE(source.find("    std::vector<double> x;\n    std::vector<std::string> label;\n    std::vector<bool> alive;\n",
+                          soa),
+              std::string::npos);
+    EXPECT_NE(source.find("std::size_t size() const noexcept { return x.size(); }", soa), std::string::npos);
+    EXPECT_NE(source.find("void push_back(const Particle& value)", soa), std::string::npos);
+    EXPECT_NE(source.find("label.push_back(std::move(value.label));", soa), std::string::npos);
+    EXPECT_NE(source.find("Particle get(std::size_t index) const { return Particle(x[index], label[index], "
+                          "alive[index]); }",
+                          soa),
+              std::string::npos);
+    EXPECT_NE(source.find("#include <vector>"), std::string::npos);
+    EXPECT_EQ(compileErrors(source, "#include <string>\n"), "");
+}
+
+TEST_F(ProjectManagerTest, MoveOnlyMembersAreOnlyMoved) {
+    std::string source = generate(R"({"type": "struct", "name": "Job", "soa": true, "attributes": [
+        {"name": "priority", "type": "int"}, {"name": "task", "type": "std::unique_ptr<int>"}], "methods": [
+        {"name": "setTask", "parameters": [{"name": "task", "type": "std::unique_ptr<int>"},
+                                           {"name": "label", "type": "std::string"}]}]})");
+    ASSERT_FALSE(source.empty());
+
+    // The setter takes ownership; other expensive parameters stay const references
+    EXPECT_NE(source.find("void setTask(std::unique_ptr<int> task, const std::string& label) {"), std::string::npos);
+    EXPECT_NE(source.find("this->task = std::move(task);"), std::string::npos);
+
+    EXPECT_NE(source.find("Job(const Job&) = delete;"), std::string::npos);
+    EXPECT_NE(source.find("Job& operator=(const Job&) = delete;"), std::string::npos);
+    EXPECT_NE(source.find("Job(Job&&) noexcept = default;"), std::string::npos);
+    size_t soa = source.find("struct JobSoA {");
+    ASSERT_NE(soa, std::string::npos);
+    EXPECT_EQ(source.find("push_back(const Job& value)", soa), std::string::npos);
+    EXPECT_NE(source.find("task.push_back(std::move(value.task));", soa), std::string::npos);
+    EXPECT_EQ(source.find(" get(", soa), std::string::npos);
+    EXPECT_EQ(compileErrors(source, "#include <memory>\n#include <string>\n"), "");
+}
+
+} // namespace
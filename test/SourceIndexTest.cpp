@@ -0,0 +1,117 @@
+// test/SourceIndexTest.cpp
+#include "SourceIndex.h"
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+class SourceIndexTest : public ::testing::Test {
+protected:
+    fs::path dir;
+
+    void SetUp() override {
+        std::string pattern = (fs::temp_directory_path() / "cpp-manager-test-XXXXXX").string();
+        dir = mkdtemp(pattern.data());
+        write("src/main.cpp", "int main() { return parseConfig(); }\n");
+        write("src/config/parser.cpp", "int parseConfig() { return 0; }\n");
+        write("include/config/parser.h", "int parseConfig();\n");
+        write("test/parser_test.cpp", "// abcXbcd\n");
+        write("src/notes.txt", "parseConfig\n");
+        write("src/.hidden.cpp", "parseConfig\n");
+        write("docs/example.cpp", "parseConfig\n");
+    }
+    void TearDown() override { fs::remove_all(dir); }
+
+    void write(const std::string& name, const std::string& content) {
+        fs::create_directories((dir / name).parent_path());
+        std::ofstream(dir / name, std::ios::binary) << content;
+    }
+    std::string path(const std::string& name) const { return (dir / name).string(); }
+
+    static std::vector<std::string> paths(const SourceIndex& index, const std::vector<size_t>& indices) {
+        std::vector<std::string> result;
+        for (size_t i : indices) {
+            result.push_back(index.files()[i].path);
+        }
+        return result;
+    }
+};
+
+TEST_F(SourceIndexTest, WalksTheSourceDirectories) {
+    SourceIndex index(dir.string());
+    index.update(path("snapshot"), false);
+    std::vector<std::string> files;
+    for (const auto& file : index.files()) {
+        files.push_back(file.path);
+    }
+    EXPECT_EQ(files, (std::vector<std::string>{"include/config/parser.h", "src/config/parser.cpp", "src/main.cpp",
+                                               "test/parser_test.cpp"}));
+    EXPECT_EQ(index.directoriesRead(), 5u);
+}
+
+TEST_F(SourceIndexTest, SnapshotSkipsUnchangedDirectories) {
+    SourceIndex first(dir.string());
+    first.update(path("snapshot"), false);
+
+    SourceIndex second(dir.string());
+    second.update(path("snapshot"), false);
+    EXPECT_EQ(second.directoriesRead(), 0u);
+    EXPECT_EQ(second.files().size(), first.files().size());
+
+    write("src/config/lexer.cpp", "");
+    SourceIndex third(dir.string());
+    third.update(path("snapshot"), false);
+    EXPECT_EQ(third.directoriesRead(), 1u);
+    EXPECT_EQ(third.files().size(), first.files().size() + 1);
+}
+
+TEST_F(SourceIndexTest, CandidatesContainEveryTrigram) {
+    SourceIndex index(dir.string());
+    index.update(path("snapshot"), true);
+    index.updateTrigrams(path("trigrams"));
+    EXPECT_EQ(paths(index, index.candidates("parseConfig")),
+              (std::vector<std::string>{"include/config/parser.h", "src/config/parser.cpp", "src/main.cpp"}));
+    EXPECT_EQ(paths(index, index.candidates("return 0")), (std::vector<std::string>{"src/config/parser.cpp"}));
+    EXPECT_TRUE(index.candidates("notInAnyFile").empty());
+    // Candidates are a superset: every trigram of "abcd" occurs, the text itself does not
+    EXPECT_EQ(paths(index, index.candidates("abcd")), (std::vector<std::string>{"test/parser_test.cpp"}));
+    EXPECT_EQ(index.candidates("in").size(), index.files().size());
+}
+
+TEST_F(SourceIndexTest, TrigramIndexRoundTrip) {
+    SourceIndex first(dir.string());
+    first.update(path("snapshot"), true);
+    first.updateTrigrams(path("trigrams"));
+    EXPECT_EQ(first.filesReindexed(), 4u);
+
+    SourceIndex second(dir.string());
+    second.update(path("snapshot"), true);
+    second.updateTrigrams(path("trigrams"));
+    EXPECT_EQ(second.filesReindexed(), 0u);
+    for (const char* text : {"parseConfig", "return 0", "abcd", "main"}) {
+        EXPECT_EQ(second.candidates(text), first.candidates(text)) << text;
+    }
+
+    write("test/parser_test.cpp", "// parseConfig() again\n");
+    SourceIndex third(dir.string());
+    third.update(path("snapshot"), true);
+    third.updateTrigrams(path("trigrams"));
+    EXPECT_EQ(third.filesReindexed(), 1u);
+    EXPECT_EQ(paths(third, third.candidates("parseConfig")).back(), "test/parser_test.cpp");
+    EXPECT_TRUE(third.candidates("abcd").empty());
+}
+
+TEST_F(SourceIndexTest, CorruptTrigramIndexIsRebuilt) {
+    write("trigrams", std::string("cpp-manager trigram index 1\nsrc/main.cpp\0\x01\x02", 43));
+    SourceIndex index(dir.string());
+    index.update(path("snapshot"), true);
+    index.updateTrigrams(path("trigrams"));
+    EXPECT_EQ(index.filesReindexed(), 4u);
+    EXPECT_EQ(paths(index, index.candidates("return 0")), (std::vector<std::string>{"src/config/parser.cpp"}));
+}
+
+} // namespace
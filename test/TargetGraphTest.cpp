@@ -0,0 +1,80 @@
+// test/TargetGraphTest.cpp
+#include "TargetGraph.h"
+#include <gtest/gtest.h>
+
+namespace {
+
+TEST(TargetGraphTest, ModuleOfPath) {
+    EXPECT_EQ(TargetGraph::moduleOf("src/net/socket.cpp"), "net");
+    EXPECT_EQ(TargetGraph::moduleOf("include/user.h"), "user");
+    EXPECT_EQ(TargetGraph::moduleOf("src/user.cpp"), "user");
+    EXPECT_EQ(TargetGraph::moduleOf("src/main.cpp"), "");
+    EXPECT_EQ(TargetGraph::moduleOf("test/user_test.cpp"), "");
+    EXPECT_EQ(TargetGraph::moduleOf("src"), "");
+}
+
+TEST(TargetGraphTest, ScanGroupsSourcesIntoModules) {
+    TargetGraph graph = TargetGraph::scan({
+        {"src/main.cpp", "#include \"net/socket.h\"\n#include \"user.h\"\n"},
+        {"src/net/socket.cpp", "#include \"net/socket.h\"\n#include <vector>\n"},
+        {"src/net/socket.h", ""},
+        {"src/user.cpp", "#include \"user.h\"\n#include \"net/socket.h\"\n"},
+        {"include/user.h", ""},
+    });
+    EXPECT_EQ(graph.modules(), (std::map<std::string, std::vector<std::string>>{
+                                   {"net", {"src/net/socket.cpp"}}, {"user", {"src/user.cpp"}}}));
+    EXPECT_TRUE(graph.droppedEdges().empty());
+
+    // Dependencies are defined before their dependents, and the executable links every module
+    std::string block = graph.cmakeBlock("app");
+    size_t net = block.find("add_library(app_net OBJECT\n        src/net/socket.cpp)");
+    size_t user = block.find("add_library(app_user OBJECT\n        src/user.cpp)");
+    ASSERT_NE(net, std::string::npos);
+    ASSERT_NE(user, std::string::npos);
+    EXPECT_LT(net, user);
+    EXPECT_NE(block.find("target_link_libraries(app_user PUBLIC app_net)"), std::string::npos);
+    EXPECT_NE(block.find("set(CPP_MANAGER_MODULES app_net app_user)"), std::string::npos);
+    EXPECT_NE(block.find("add_executable(app src/main.cpp)"), std::string::npos);
+    EXPECT_EQ(block.find("CXX_MODULES"), std::string::npos);
+}
+
+TEST(TargetGraphTest, DropsTheEdgeThatClosesACycle) {
+    TargetGraph graph = TargetGraph::scan({
+        {"src/a/a.cpp", "#include \"b/b.h\"\n"},
+        {"src/a/a.h", ""},
+        {"src/b/b.cpp", "#include \"a/a.h\"\n"},
+        {"src/b/b.h", ""},
+    });
+    EXPECT_EQ(graph.droppedEdges(), (std::vector<std::pair<std::string, std::string>>{{"b", "a"}}));
+    std::string block = graph.cmakeBlock("app");
+    EXPECT_NE(block.find("target_link_libraries(app_a PUBLIC app_b)"), std::string::npos);
+    EXPECT_EQ(block.find("target_link_libraries(app_b"), std::string::npos);
+}
+
+TEST(TargetGraphTest, InterfaceUnitsGoIntoAModuleFileSet) {
+    TargetGraph graph = TargetGraph::scan({
+        {"src/main.cpp", "import geo;\n"},
+        {"src/geo.cppm", "export module geo;\n"},
+        {"src/geo.cpp", "module geo;\n"},
+    });
+    std::string block = graph.cmakeBlock("app");
+    EXPECT_NE(block.find("CMAKE_VERSION VERSION_LESS 3.28"), std::string::npos);
+    EXPECT_NE(block.find("target_sources(app_geo PUBLIC FILE_SET CXX_MODULES FILES\n        src/geo.cppm)"),
+              std::string::npos);
+    EXPECT_NE(block.find("add_library(app_geo OBJECT\n        src/geo.cpp)"), std::string::npos);
+}
+
+TEST(TargetGraphTest, SpliceReplacesOnlyTheMarkedBlock) {
+    TargetGraph graph = TargetGraph::scan({{"src/main.cpp", ""}});
+    std::string cmakeLists = "project(app)\n" + graph.cmakeBlock("old") + "install(TARGETS app)\n";
+    ASSERT_TRUE(TargetGraph::hasBlock(cmakeLists));
+    ASSERT_TRUE(TargetGraph::splice(cmakeLists, graph.cmakeBlock("app")));
+    EXPECT_EQ(cmakeLists, "project(app)\n" + graph.cmakeBlock("app") + "install(TARGETS app)\n");
+
+    std::string handWritten = "project(app)\nadd_executable(app src/main.cpp)\n";
+    EXPECT_FALSE(TargetGraph::hasBlock(handWritten));
+    EXPECT_FALSE(TargetGraph::splice(handWritten, graph.cmakeBlock("app")));
+    EXPECT_EQ(handWritten, "project(app)\nadd_executable(app src/main.cpp)\n");
+}
+
+} // namespace
@@ -0,0 +1,80 @@
+// test/TestRunnerTest.cpp
+#include "TestRunner.h"
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+class TestRunnerTest : public ::testing::Test {
+protected:
+    fs::path dir;
+
+    void SetUp() override {
+        std::string pattern = (fs::temp_directory_path() / "cpp-manager-test-XXXXXX").string();
+        dir = mkdtemp(pattern.data());
+    }
+    void TearDown() override { fs::remove_all(dir); }
+
+    std::string write(const std::string& name, const std::string& content) {
+        std::ofstream(dir / name, std::ios::binary) << content;
+        return (dir / name).string();
+    }
+};
+
+TEST_F(TestRunnerTest, RecognizesGoogleTestBinaries) {
+    std::string exe = write("gtest", std::string("\x7f" "ELF\0--gtest_list_tests\0", 23));
+    EXPECT_EQ(TestRunner::listCommand(exe), (std::vector<std::string>{exe, "--gtest_list_tests"}));
+}
+
+TEST_F(TestRunnerTest, RecognizesBothCatch2Generations) {
+    std::string v2 = write("catch2", "--list-test-names-only");
+    EXPECT_EQ(TestRunner::listCommand(v2), (std::vector<std::string>{v2, "--list-test-names-only"}));
+    std::string v3 = write("catch3", "Catch::Session --list-tests");
+    EXPECT_EQ(TestRunner::listCommand(v3), (std::vector<std::string>{v3, "--list-tests", "--verbosity", "quiet"}));
+}
+
+TEST_F(TestRunnerTest, LeavesOtherExecutablesWhole) {
+    EXPECT_TRUE(TestRunner::listCommand(write("plain", "--list-tests without the namespace")).empty());
+    EXPECT_TRUE(TestRunner::listCommand(write("empty", "")).empty());
+    EXPECT_TRUE(TestRunner::listCommand((dir / "missing").string()).empty());
+}
+
+TEST_F(TestRunnerTest, WillFailBinariesRunWhole) {
+    // A GoogleTest binary with one case that fails on purpose
+    std::string exe = write("expected_failure", "#!/bin/sh\n# --gtest_list_tests\n"
+                                                "case \"$1\" in\n"
+                                                "--gtest_list_tests) printf 'Suite.\\n  Fails\\n  Passes\\n' ;;\n"
+                                                "--gtest_filter=Suite.Passes) exit 0 ;;\n"
+                                                "*) exit 1 ;;\n"
+                                                "esac\n");
+    fs::permissions(exe, fs::perms::owner_all);
+    TestCase test;
+    test.name = "expected_failure";
+    test.command = {exe};
+    test.willFail = true;
+
+    TestRunner runner(dir.string(), 2);
+    EXPECT_EQ(runner.run({test}, (dir / "results.xml").string()), 0);
+    test.willFail = false;
+    EXPECT_NE(runner.run({test}, (dir / "results.xml").string()), 0);
+}
+
+TEST_F(TestRunnerTest, DurationsRoundTrip) {
+    std::map<std::string, double> durations = {{"math/Add.Works", 0.25}, {"io", 3}};
+    std::string path = (dir / "nested" / "test-durations").string();
+    TestRunner::writeDurations(path, durations);
+    EXPECT_EQ(TestRunner::readDurations(path), durations);
+}
+
+TEST_F(TestRunnerTest, CorruptDurationLinesAreSkipped) {
+    std::string path = write("test-durations", "garbage\n\tno/seconds\n1.5x\tbad/suffix\n-2\tnegative/time\n"
+                                               "nan\tnot/finite\n0.5\tgood/one\n2");
+    EXPECT_EQ(TestRunner::readDurations(path), (std::map<std::string, double>{{"good/one", 0.5}}));
+    EXPECT_TRUE(TestRunner::readDurations((dir / "missing").string()).empty());
+}
+
+} // namespace